@@ -1,4 +1,4 @@
-QT += core gui sql
+QT += core gui sql concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
 
@@ -7,23 +7,55 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
 
 CONFIG += c++17
 
+# .csv.gz input: the zlib bundled with Qt, or the system one when Qt is built against it
+qtConfig(system-zlib) {
+    LIBS += -lz
+} else {
+    QT += zlib-private
+}
+
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 
 SOURCES += \
+    benchmark.cpp \
     comparetable.cpp \
+    coredataset.cpp \
+    coregraph.cpp \
     csvFunctions.cpp \
+    csvcache.cpp \
+    csvparser.cpp \
+    csvscanner.cpp \
     database.cpp \
+    gzipdevice.cpp \
     graphFunctions.cpp \
+    graphregistry.cpp \
     main.cpp \
+    matrixstore.cpp \
     mainwindow.cpp \
     qcustomplot.cpp \
-    setting.cpp
+    resampler.cpp \
+    sessionhistory.cpp \
+    setting.cpp \
+    statkernels.cpp \
+    tararchive.cpp
 
 HEADERS += \
     setting.h \
+    csvparser.h \
+    coredataset.h \
+    coregraph.h \
+    csvcache.h \
+    resampler.h \
+    csvscanner.h \
+    benchmark.h \
+    matrixstore.h \
+    gzipdevice.h \
+    graphregistry.h \
+    statkernels.h \
+    tararchive.h \
     ui_mainwindow.h\
     mainwindow.h \
     qcustomplot.h
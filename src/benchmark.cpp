@@ -0,0 +1,309 @@
+/**
+ *@file benchmark.cpp
+ *@brief Implementation of the built-in microbenchmarks
+ *
+ *This file contains the microbenchmarks started with the --benchmark command line option. They
+ *run on synthetic sweep data generated in memory, so the numbers of different station PCs can be
+ *compared directly. The CSV scanner is timed on every SIMD path the CPU supports and reported in
+ *bytes per cycle (time stamp counter cycles) and MB/s, followed by the full parse throughput.
+ *The average and distance ratio statistics are timed on 100, 1k and 10k synthetic cores, with
+ *the former indexed scalar loops as the baseline for every kernel path.
+ *
+ *@note The benchmarks run without the GUI and do not touch the database or the CSV cache.
+ *
+ *@date[10/16/26]
+ */
+#include "benchmark.h"
+#include "csvscanner.h"
+#include "csvparser.h"
+#include "statkernels.h"
+#include <QByteArray>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QtNumeric>
+#include <cmath>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define BENCHMARK_HAS_TSC
+#endif
+
+namespace
+{
+    const int sweepRows = 2000000;
+    const int repetitions = 10;
+    const int scanBlockBytes = 64 * 1024;
+    const int corePoints = 1000;
+
+    inline quint64 cycleCounter()
+    {
+#ifdef BENCHMARK_HAS_TSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    // A FREQUENCY,Ls,Rs sweep shaped like an LCR meter export
+    QByteArray makeSweep()
+    {
+        QByteArray csv("FREQUENCY,Ls,Rs\n");
+        csv.reserve(sweepRows * 40);
+
+        QRandomGenerator random(42);
+        for (int row = 0; row < sweepRows; ++row)
+        {
+            double frequency = 20.0 + row * 5.0;
+            csv += QByteArray::number(frequency, 'g', 10) + ',' +
+                   QByteArray::number(1e-6 * (1.0 + random.generateDouble()), 'e', 9) + ',' +
+                   QByteArray::number(10.0 * random.generateDouble(), 'e', 9) + '\n';
+        }
+
+        return csv;
+    }
+
+    void printResult(QTextStream &out, const QString &name, qint64 bytes, qint64 elapsedNs, quint64 cycles)
+    {
+        out << qSetFieldWidth(14) << Qt::left << name << qSetFieldWidth(0);
+        out << QString("%1 MB/s").arg(bytes / 1e6 / (elapsedNs / 1e9), 9, 'f', 1);
+        if (cycles > 0)
+        {
+            out << QString("  %1 bytes/cycle").arg(double(bytes) / cycles, 6, 'f', 2);
+        }
+
+        out << Qt::endl;
+    }
+
+    void benchmarkScanner(QTextStream &out, const QByteArray &csv)
+    {
+        out << "CSV scanner (best path: " << CsvScanner::pathName(CsvScanner::bestPath()) << ")" << Qt::endl;
+
+        QVector<quint32> positions(scanBlockBytes);
+        const CsvScanner::Path paths[] = { CsvScanner::Scalar, CsvScanner::Sse2, CsvScanner::Avx2 };
+        for (CsvScanner::Path path: paths)
+        {
+            if (!CsvScanner::isSupported(path))
+            {
+                out << qSetFieldWidth(14) << Qt::left << CsvScanner::pathName(path) << qSetFieldWidth(0) << "not supported" << Qt::endl;
+                continue;
+            }
+
+            CsvScanner scanner(',', path);
+            qint64 found = 0;
+
+            QElapsedTimer timer;
+            timer.start();
+            quint64 startCycles = cycleCounter();
+
+            for (int repetition = 0; repetition < repetitions; ++repetition)
+            {
+                for (int offset = 0; offset < csv.size(); offset += scanBlockBytes)
+                {
+                    int size = qMin(scanBlockBytes, int(csv.size()) - offset);
+                    found += scanner.scan(csv.constData() + offset, size, positions.data());
+                }
+            }
+
+            quint64 cycles = cycleCounter() - startCycles;
+            qint64 elapsedNs = timer.nsecsElapsed();
+
+            // found keeps the scans from being optimized away
+            printResult(out, QString("%1 (%2)").arg(CsvScanner::pathName(path)).arg(found / repetitions),
+                        qint64(csv.size()) * repetitions, elapsedNs, cycles);
+        }
+    }
+
+    void benchmarkParser(QTextStream &out, const QByteArray &csv)
+    {
+        out << "CSV parser" << Qt::endl;
+
+        CsvParser parser(0.0, 1e12, 0.0, 1e12);
+
+        QElapsedTimer timer;
+        timer.start();
+        quint64 startCycles = cycleCounter();
+
+        for (int repetition = 0; repetition < repetitions; ++repetition)
+        {
+            CsvParseResult result;
+            parser.parseBuffer(csv.constData(), csv.size(), result);
+        }
+
+        printResult(out, "parseBuffer", qint64(csv.size()) * repetitions, timer.nsecsElapsed(), cycleCounter() - startCycles);
+    }
+
+    // cores x corePoints rows with NaN edges like cores swept on a narrower range, one core in ten hidden
+    struct CoreStudy
+    {
+        QVector<double> matrix;
+        QVector<bool> visible;
+        int cores;
+    };
+
+    CoreStudy makeStudy(int cores)
+    {
+        CoreStudy study;
+        study.cores = cores;
+        study.matrix.resize(cores * corePoints);
+        study.visible.resize(cores);
+
+        QRandomGenerator random(7);
+        for (int core = 0; core < cores; ++core)
+        {
+            int edge = random.bounded(corePoints / 20);
+            for (int i = 0; i < corePoints; ++i)
+            {
+                bool covered = i >= edge && i < corePoints - edge;
+                study.matrix[core * corePoints + i] = covered ? 1e-6 * (1.0 + random.generateDouble()) : qQNaN();
+            }
+
+            study.visible[core] = core % 10 != 9;
+        }
+
+        return study;
+    }
+
+    // The loops the kernels replaced, indexed through QVector with a NaN branch per point
+    double baselinePass(const CoreStudy &study, QVector<double> &averageValues)
+    {
+        QVector<double> sums(corePoints, 0.0);
+        QVector<int> counts(corePoints, 0);
+        for (int core = 0; core < study.cores; ++core)
+        {
+            if (!study.visible[core])
+            {
+                continue;
+            }
+
+            ColumnSpan row(study.matrix.constData() + core * corePoints, corePoints);
+            for (int i = 0; i < corePoints; ++i)
+            {
+                bool valid = !qIsNaN(row[i]);
+                sums[i] += valid ? row[i] : 0.0;
+                counts[i] += valid;
+            }
+        }
+
+        for (int i = 0; i < corePoints; ++i)
+        {
+            averageValues[i] = counts[i] > 0 ? sums[i] / counts[i] : qQNaN();
+        }
+
+        double total = 0.0;
+        for (int core = 0; core < study.cores; ++core)
+        {
+            if (!study.visible[core])
+            {
+                continue;
+            }
+
+            ColumnSpan row(study.matrix.constData() + core * corePoints, corePoints);
+            for (int j = 0; j < corePoints; ++j)
+            {
+                double difference = std::abs(row[j] - averageValues[j]);
+                if (!qIsNaN(difference))
+                {
+                    total += difference;
+                }
+            }
+        }
+
+        return total;
+    }
+
+    double kernelPass(const StatKernels &kernels, const CoreStudy &study, QVector<double> &averageValues)
+    {
+        QVector<double> sums(corePoints, 0.0);
+        QVector<int> counts(corePoints, 0);
+        for (int core = 0; core < study.cores; ++core)
+        {
+            if (study.visible[core])
+            {
+                kernels.accumulate(study.matrix.constData() + core * corePoints, corePoints, sums.data(), counts.data());
+            }
+        }
+
+        kernels.mean(sums.constData(), counts.constData(), corePoints, averageValues.data());
+
+        double total = 0.0;
+        for (int core = 0; core < study.cores; ++core)
+        {
+            if (study.visible[core])
+            {
+                int points = 0;
+                total += kernels.absoluteDifference(study.matrix.constData() + core * corePoints, averageValues.constData(), corePoints, &points);
+            }
+        }
+
+        return total;
+    }
+
+    void printPass(QTextStream &out, const QString &name, qint64 elapsedNs, int runs, double baselineNs, double total)
+    {
+        double passNs = double(elapsedNs) / runs;
+        out << qSetFieldWidth(14) << Qt::left << name << qSetFieldWidth(0);
+        out << QString("%1 ms/pass  %2x").arg(passNs / 1e6, 9, 'f', 3).arg(baselineNs / passNs, 5, 'f', 2);
+        out << QString("  (%1)").arg(total, 0, 'g', 6) << Qt::endl;
+    }
+
+    // One pass is the average of the visible cores and the distance of each to it
+    void benchmarkStatistics(QTextStream &out)
+    {
+        out << "Average and distance ratios (" << corePoints << " points per core, best path: "
+            << StatKernels::pathName(StatKernels::bestPath()) << ")" << Qt::endl;
+
+        for (int cores: {100, 1000, 10000})
+        {
+            CoreStudy study = makeStudy(cores);
+            QVector<double> averageValues(corePoints);
+            int runs = qMax(5, 20000 / cores);
+            out << cores << " cores, " << runs << " runs" << Qt::endl;
+
+            QElapsedTimer timer;
+            timer.start();
+            double total = 0.0;
+            for (int run = 0; run < runs; ++run)
+            {
+                total += baselinePass(study, averageValues);
+            }
+
+            qint64 baselineElapsedNs = timer.nsecsElapsed();
+            double baselineNs = double(baselineElapsedNs) / runs;
+            printPass(out, "Indexed loop", baselineElapsedNs, runs, baselineNs, total / runs);
+
+            const StatKernels::Path paths[] = { StatKernels::Scalar, StatKernels::Sse2, StatKernels::Avx2 };
+            for (StatKernels::Path path: paths)
+            {
+                if (!StatKernels::isSupported(path))
+                {
+                    out << qSetFieldWidth(14) << Qt::left << StatKernels::pathName(path) << qSetFieldWidth(0) << "not supported" << Qt::endl;
+                    continue;
+                }
+
+                StatKernels kernels(path);
+                timer.restart();
+                total = 0.0;
+                for (int run = 0; run < runs; ++run)
+                {
+                    total += kernelPass(kernels, study, averageValues);
+                }
+
+                printPass(out, StatKernels::pathName(path), timer.nsecsElapsed(), runs, baselineNs, total / runs);
+            }
+        }
+    }
+}
+
+int runBenchmarks(QTextStream &out)
+{
+    QByteArray csv = makeSweep();
+    out << "Synthetic sweep: " << sweepRows << " rows, " << csv.size() / 1e6 << " MB, " << repetitions << " runs" << Qt::endl << Qt::endl;
+
+    benchmarkScanner(out, csv);
+    out << Qt::endl;
+    benchmarkParser(out, csv);
+    out << Qt::endl;
+    benchmarkStatistics(out);
+
+    return 0;
+}
@@ -0,0 +1,9 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QTextStream>
+
+// Command line microbenchmarks, run with "Whilone --benchmark > report.txt"
+int runBenchmarks(QTextStream &out);
+
+#endif // BENCHMARK_H
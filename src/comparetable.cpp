@@ -24,45 +24,48 @@
 void MainWindow::compareFrequency(double targetFrequency)
 {
     // Find the data point index in the average graph's data
-    int averageGraphIndex = -1;
+    QCPGraph *averageGraph = this->averageGraph();
 
-    for (int i = 0; i < ui->Plot->graphCount(); ++i)
-    {
-        QCPGraph *graph = ui->Plot->graph(i);
-        if (graph && (graph->name() == "Average LS" || graph->name() == "Average RS"))
-        {
-            averageGraphIndex = i;
-            break;
-        }
-    }
-
-    if (averageGraphIndex == -1)
+    if (averageGraph == nullptr)
     {
         qDebug() << "Average graph not found!";
         return;	// Handle the case where the average graph is not found
     }
 
-    int averageGraphDataPointIndex = findNearestDataPoint(ui->Plot->graph(averageGraphIndex)->data(), targetFrequency);
+    int averageGraphDataPointIndex = findNearestDataPoint(averageGraph->data(), targetFrequency);
 
     if (averageGraphDataPointIndex == -1)
         return;
 
     // Get the y value of the average graph at the target frequency
-    double averageGraphY = ui->Plot->graph(averageGraphIndex)->data()->at(averageGraphDataPointIndex)->value;
+    double averageGraphY = averageGraph->data()->at(averageGraphDataPointIndex)->value;
+
+    // Every core at the grid frequency closest to the target, contiguous in the per-frequency view
+    bool useLsData = ui->radioButton_Ls->isChecked();
+    const ChannelMatrix &matrix = dataset.channel(useLsData);
+    int column = matrix.nearestFrequency(targetFrequency);
+    if (column == -1)
+        return;
+
+    // The per-frequency view is built on first use, it needs room in the core store
+    const ColumnSpan values = matrix.frequency(column);
+    if (values.size() < matrix.coreCount())
+    {
+        QMessageBox::warning(this, "Warning", "The core store could not grow, free space in the temporary folder");
+        return;
+    }
+
+    recordStep();
+
+    double frequency = matrix.frequencies()[column];
 
     // Find the maximum difference among all graph points at the target frequency
     double maxDifference = 0.0;
-    for (int i = 0; i < ui->Plot->graphCount(); ++i)
+    for (int i = 0; i < matrix.coreCount(); ++i)
     {
-        QCPGraph *graph = ui->Plot->graph(i);
-        if (graph && graph->visible())
+        if (matrix.isVisible(i) && !qIsNaN(values[i]))
         {
-            int dataPointIndex = findNearestDataPoint(graph->data(), targetFrequency);
-            if (dataPointIndex == -1)
-                continue;
-
-            double graphY = graph->data()->at(dataPointIndex)->value;
-            double difference = std::abs(graphY - averageGraphY);
+            double difference = std::abs(values[i] - averageGraphY);
 
             if (difference > maxDifference)
             {
@@ -72,26 +75,25 @@ void MainWindow::compareFrequency(double targetFrequency)
     }
 
     // Calculate distance ratio and distances for each graph's point
-    for (int i = 0; i < ui->Plot->graphCount(); ++i)
+    for (int i = 0; i < matrix.coreCount(); ++i)
     {
-        QCPGraph *graph = ui->Plot->graph(i);
-        if (graph && graph->visible())
+        QCPGraph *graph = coreGraph(useLsData, i);
+        if (graph && matrix.isVisible(i) && !qIsNaN(values[i]))
         {
-            int dataPointIndex = findNearestDataPoint(graph->data(), targetFrequency);
-            if (dataPointIndex == -1)
-                continue;
-
-            double graphY = graph->data()->at(dataPointIndex)->value;
-            double distanceToAverage = std::abs(graphY - averageGraphY);
+            double distanceToAverage = std::abs(values[i] - averageGraphY);
             double distanceRatio = (maxDifference > 0.0) ? distanceToAverage / maxDifference : 0.0;
 
-            // Get the current time
-
             // Add the recorded point to the list
-            recordedPoints.append(RecordedPoint(graph->data()->at(dataPointIndex)->key, graphY, graph->name(), distanceRatio, distanceToAverage));
+            recordedPoints.append(RecordedPoint(frequency, values[i], graph->name(), distanceRatio, distanceToAverage));
         }
     }
 
+    // The average graph is listed with the cores, at distance 0
+    if (averageGraph->visible())
+    {
+        recordedPoints.append(RecordedPoint(averageGraph->data()->at(averageGraphDataPointIndex)->key, averageGraphY, averageGraph->name(), 0.0, 0.0));
+    }
+
     // Update the table widget with the new recorded points
     updateRecordedPointsTable();
 }
@@ -131,6 +133,7 @@ void MainWindow::updateRecordedPointsTable()
 // Button -> Clear Table
 void MainWindow::on_btn_tablo_clear_clicked()	//Clear Table Data
 {
+    recordStep();
     recordedPoints.clear();
 
 }
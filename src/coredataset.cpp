@@ -0,0 +1,394 @@
+/**
+ *@file coredataset.cpp
+ *@brief Implementation of the columnar store that holds the data of every loaded core
+ *
+ *This file contains the implementation of the dataset store behind the plots and statistics.
+ *Each channel keeps all cores in a single row-major cores x frequencies matrix on a frequency
+ *grid shared by the cores, so averages and distance ratios walk contiguous memory instead of
+ *one heap block per core. A column-major copy, built only when asked for, serves the
+ *statistics that look at every core at one frequency. Each core is resampled onto the shared
+ *grid when it is set, so the statistics read aligned rows; points outside its sweep are NaN.
+ *Both matrices sit in a MatrixStore, which moves large studies to a memory-mapped file.
+ *Every parsed core also gets a min/max pyramid over power-of-two buckets of the grid, so a
+ *zoomed-out graph draws from the level matching its pixels instead of from every point.
+ *The loader sets the cores of a batch through a BatchOrder, in slot order until both channels
+ *have a grid, so the grid of a session is the same whichever file finishes parsing first.
+ *
+ *@note The dataset is only changed on the GUI thread, the load workers hand their columns over in results.
+ *
+ *@date[10/16/26]
+ */
+#include "coredataset.h"
+#include <QtNumeric>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const int transposeTile = 64;
+
+    template<typename T>
+    void keepItems(QList<T> &items, const QVector<bool> &keep)
+    {
+        int kept = 0;
+        for (int i = 0; i < items.size(); ++i)
+        {
+            if (keep[i])
+            {
+                items[kept++] = items[i];
+            }
+        }
+
+        items.resize(kept);
+    }
+}
+
+void ChannelMatrix::clear()
+{
+    grid.clear();
+    values.clear();
+    transposed.clear();
+    transposedValid = false;
+    pyramids.clear();
+    levelOffsets.clear();
+    pyramidWidth = 0;
+    filled.clear();
+    visible.clear();
+    summaries.clear();
+    resampler.clear();
+    cores = 0;
+}
+
+ColumnSpan ChannelMatrix::core(int core) const
+{
+    if (!filled[core])
+    {
+        return ColumnSpan();
+    }
+
+    return ColumnSpan(values.constData() + qint64(core) * grid.size(), grid.size());
+}
+
+// Column of the transposed matrix, the transpose is redone after the cores change
+ColumnSpan ChannelMatrix::frequency(int column) const
+{
+    if (!transposedValid)
+    {
+        int width = grid.size();
+        if (!transposed.resize(qint64(width) * cores, qQNaN()))
+        {
+            return ColumnSpan();
+        }
+
+        double *target = transposed.data();
+
+        // Tiles keep both the rows read and the columns written in cache
+        for (int coreBlock = 0; coreBlock < cores; coreBlock += transposeTile)
+        {
+            int coreEnd = qMin(coreBlock + transposeTile, cores);
+            for (int columnBlock = 0; columnBlock < width; columnBlock += transposeTile)
+            {
+                int columnEnd = qMin(columnBlock + transposeTile, width);
+                for (int core = coreBlock; core < coreEnd; ++core)
+                {
+                    const double *source = values.constData() + qint64(core) * width;
+                    for (int i = columnBlock; i < columnEnd; ++i)
+                    {
+                        target[qint64(i) * cores + core] = source[i];
+                    }
+                }
+            }
+        }
+
+        transposedValid = true;
+    }
+
+    return ColumnSpan(transposed.constData() + qint64(column) * cores, cores);
+}
+
+// Grid column closest to frequency, -1 without a grid
+int ChannelMatrix::nearestFrequency(double frequency) const
+{
+    if (grid.isEmpty())
+    {
+        return -1;
+    }
+
+    int upper = std::lower_bound(grid.begin(), grid.end(), frequency) - grid.begin();
+    if (upper == grid.size())
+    {
+        return upper - 1;
+    }
+
+    if (upper > 0 && frequency - grid[upper - 1] <= grid[upper] - frequency)
+    {
+        return upper - 1;
+    }
+
+    return upper;
+}
+
+const double *ChannelMatrix::pyramid(int core, int level) const
+{
+    if (!filled[core] || level < 0 || level >= levelOffsets.size())
+    {
+        return nullptr;
+    }
+
+    return pyramids.constData() + qint64(core) * pyramidWidth + levelOffsets[level];
+}
+
+// New empty row, filled once its file is parsed
+bool ChannelMatrix::appendCore()
+{
+    if (!values.resize(values.size() + grid.size(), qQNaN()))
+    {
+        return false;
+    }
+
+    if (!pyramids.resize(pyramids.size() + pyramidWidth, qQNaN()))
+    {
+        // Shrinking never remaps
+        values.resize(values.size() - grid.size(), qQNaN());
+        return false;
+    }
+
+    filled.append(false);
+    visible.append(true);
+    summaries.append(ChannelSummary());
+    ++cores;
+    transposedValid = false;
+    return true;
+}
+
+bool ChannelMatrix::setCore(int core, const ColumnSpan &keys, const ColumnSpan &coreValues, const ChannelSummary &summary)
+{
+    // The first core set makes the grid, the loader sets the lowest slot first. The rows reserved
+    // so far are still empty
+    if (grid.isEmpty() && !keys.isEmpty())
+    {
+        QVector<double> newGrid = options.makeGrid(keys);
+        if (!values.assign(qint64(cores) * newGrid.size(), qQNaN()))
+        {
+            return false;
+        }
+
+        grid = newGrid;
+        if (!layoutPyramid())
+        {
+            // Back to no grid, the next core tries again
+            grid.clear();
+            values.resize(0, qQNaN());
+            return false;
+        }
+    }
+
+    if (!keys.isEmpty())
+    {
+        resampler.resample(keys, coreValues, grid, options.interpolation, row(core));
+        buildPyramid(core);
+    }
+
+    filled[core] = !keys.isEmpty();
+    summaries[core] = summary;
+    transposedValid = false;
+    return true;
+}
+
+void ChannelMatrix::clearCore(int core)
+{
+    std::fill(row(core), row(core) + grid.size(), qQNaN());
+    std::fill(pyramids.data() + qint64(core) * pyramidWidth, pyramids.data() + qint64(core + 1) * pyramidWidth, qQNaN());
+    filled[core] = false;
+    summaries[core] = ChannelSummary();
+    transposedValid = false;
+}
+
+void ChannelMatrix::removeCores(const QVector<bool> &keep)
+{
+    values.removeBlocks(keep, grid.size());
+    pyramids.removeBlocks(keep, pyramidWidth);
+    keepItems(filled, keep);
+    keepItems(visible, keep);
+    keepItems(summaries, keep);
+    cores = filled.size();
+    transposedValid = false;
+
+    // The next load sets a new grid
+    if (cores == 0)
+    {
+        clear();
+    }
+}
+
+// Levels down to two buckets, set once the grid is known
+bool ChannelMatrix::layoutPyramid()
+{
+    levelOffsets.clear();
+    pyramidWidth = 0;
+
+    int width = grid.size();
+    for (int level = 0; bucketSize(level) < width; ++level)
+    {
+        int buckets = (width + bucketSize(level) - 1) / bucketSize(level);
+        levelOffsets.append(pyramidWidth);
+        pyramidWidth += 2 * buckets;
+    }
+
+    if (!pyramids.assign(qint64(cores) * pyramidWidth, qQNaN()))
+    {
+        levelOffsets.clear();
+        pyramidWidth = 0;
+        return false;
+    }
+
+    return true;
+}
+
+// Level 0 from the row, every other level from pairs of buckets of the one below.
+// fmin and fmax skip NaN, a bucket with no value at all stays NaN.
+void ChannelMatrix::buildPyramid(int core)
+{
+    if (levelOffsets.isEmpty())
+    {
+        return;
+    }
+
+    int width = grid.size();
+    const double *source = values.constData() + qint64(core) * width;
+    double *target = pyramids.data() + qint64(core) * pyramidWidth;
+
+    int buckets = (width + firstBucketSize - 1) / firstBucketSize;
+    for (int j = 0; j < buckets; ++j)
+    {
+        double low = qQNaN();
+        double high = qQNaN();
+        int end = qMin(width, (j + 1) * firstBucketSize);
+        for (int i = j * firstBucketSize; i < end; ++i)
+        {
+            low = std::fmin(low, source[i]);
+            high = std::fmax(high, source[i]);
+        }
+
+        target[2 * j] = low;
+        target[2 * j + 1] = high;
+    }
+
+    for (int level = 1; level < levelOffsets.size(); ++level)
+    {
+        const double *below = target + levelOffsets[level - 1];
+        double *current = target + levelOffsets[level];
+        int belowBuckets = buckets;
+        buckets = (width + bucketSize(level) - 1) / bucketSize(level);
+
+        for (int j = 0; j < buckets; ++j)
+        {
+            int second = qMin(2 * j + 1, belowBuckets - 1);
+            current[2 * j] = std::fmin(below[4 * j], below[2 * second]);
+            current[2 * j + 1] = std::fmax(below[4 * j + 1], below[2 * second + 1]);
+        }
+    }
+}
+
+void CoreDataset::clear()
+{
+    names.clear();
+    hashes.clear();
+    lsChannel.clear();
+    rsChannel.clear();
+}
+
+bool CoreDataset::appendCore(const QString &name)
+{
+    if (!lsChannel.appendCore())
+    {
+        return false;
+    }
+
+    if (!rsChannel.appendCore())
+    {
+        QVector<bool> keep(lsChannel.coreCount(), true);
+        keep.last() = false;
+        lsChannel.removeCores(keep);
+        return false;
+    }
+
+    names.append(name);
+    hashes.append(0);
+    return true;
+}
+
+// Copy the windows of a parsed file into both channels, the parsed columns can then be dropped.
+// The columns of a streamed file are read from its mapped store.
+bool CoreDataset::setCore(int core, const CsvParseResult &parsed)
+{
+    ColumnSpan frequencies = parsed.frequencies();
+    if (!lsChannel.setCore(core, ColumnSpan(frequencies, parsed.lsWindow), ColumnSpan(parsed.lsValues(), parsed.lsWindow), parsed.lsSummary) ||
+        !rsChannel.setCore(core, ColumnSpan(frequencies, parsed.rsWindow), ColumnSpan(parsed.rsValues(), parsed.rsWindow), parsed.rsSummary))
+    {
+        return false;
+    }
+
+    hashes[core] = parsed.contentHash;
+    return true;
+}
+
+void CoreDataset::clearCore(int core)
+{
+    hashes[core] = 0;
+    lsChannel.clearCore(core);
+    rsChannel.clearCore(core);
+}
+
+void CoreDataset::removeCores(const QVector<bool> &keep)
+{
+    keepItems(names, keep);
+    keepItems(hashes, keep);
+    lsChannel.removeCores(keep);
+    rsChannel.removeCores(keep);
+}
+
+void BatchOrder::reset(int count)
+{
+    arrived = QVector<bool> (count, false);
+    next = 0;
+    released = false;
+}
+
+QVector<int> BatchOrder::arrive(int index)
+{
+    if (released)
+    {
+        return QVector<int> {index};
+    }
+
+    arrived[index] = true;
+
+    QVector<int> ready;
+    while (next < arrived.size() && arrived[next])
+    {
+        ready.append(next++);
+    }
+
+    return ready;
+}
+
+QVector<int> BatchOrder::release()
+{
+    QVector<int> ready;
+    if (released)
+    {
+        return ready;
+    }
+
+    for (; next < arrived.size(); ++next)
+    {
+        if (arrived[next])
+        {
+            ready.append(next);
+        }
+    }
+
+    released = true;
+    return ready;
+}
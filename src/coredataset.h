@@ -0,0 +1,130 @@
+#ifndef COREDATASET_H
+#define COREDATASET_H
+
+#include <QString>
+#include <QVector>
+#include <QStringList>
+#include "csvparser.h"
+#include "resampler.h"
+#include "matrixstore.h"
+
+// One channel (Ls or Rs) of every loaded core as a row-major cores x frequencies matrix on a
+// shared frequency grid. A column-major copy serves per-frequency statistics.
+class ChannelMatrix
+{
+public:
+    void clear();
+
+    // Grid and interpolation of the next load. The grid is made when the first core is set; the
+    // loader sets the cores of a batch in slot order until then (see BatchOrder), so the grid
+    // comes from the lowest slot whose file has data in this channel.
+    const GridOptions &gridOptions() const { return options; }
+    void setGridOptions(const GridOptions &gridOptions) { options = gridOptions; }
+
+    int coreCount() const { return cores; }
+    int frequencyCount() const { return grid.size(); }
+    const QVector<double> &frequencies() const { return grid; }
+
+    // Values of one core on the grid, empty until the core is parsed
+    ColumnSpan core(int core) const;
+    bool hasCore(int core) const { return filled[core]; }
+
+    // Values of every core at one grid frequency, contiguous over the cores
+    ColumnSpan frequency(int column) const;
+    int nearestFrequency(double frequency) const;
+
+    // Min and max of a core per bucket of grid points, [min, max] per bucket. Level 0 buckets
+    // firstBucketSize points and each level doubles the bucket. nullptr until the core is parsed.
+    int pyramidLevels() const { return levelOffsets.size(); }
+    static int bucketSize(int level) { return firstBucketSize << level; }
+    const double *pyramid(int core, int level) const;
+
+    bool isVisible(int core) const { return visible[core]; }
+    void setVisible(int core, bool isVisible) { visible[core] = isVisible; }
+    const QVector<bool> &visibility() const { return visible; }
+    void setVisibility(const QVector<bool> &coreVisibility) { visible = coreVisibility; }
+
+    const ChannelSummary &summary(int core) const { return summaries[core]; }
+    ChannelSummary &summary(int core) { return summaries[core]; }
+
+    // false when the store cannot grow, the matrix is then left as it was
+    bool appendCore();
+    bool setCore(int core, const ColumnSpan &keys, const ColumnSpan &values, const ChannelSummary &summary);
+    void clearCore(int core);
+    void removeCores(const QVector<bool> &keep);
+
+private:
+    double *row(int core) { return values.data() + qint64(core) * grid.size(); }
+    bool layoutPyramid();
+    void buildPyramid(int core);
+
+    static const int firstBucketSize = 4;
+
+    GridOptions options;
+    Resampler resampler;
+    QVector<double> grid;	// Made from the first core set
+    MatrixStore values;	// cores x grid.size()
+    mutable MatrixStore transposed;	// grid.size() x cores, built when first asked for
+    MatrixStore pyramids;	// cores x pyramidWidth, every level of a core one after the other
+    QVector<qint64> levelOffsets;	// Start of each level in a core's pyramid
+    qint64 pyramidWidth = 0;
+    mutable bool transposedValid = false;
+    QVector<bool> filled;
+    QVector<bool> visible;
+    QVector<ChannelSummary> summaries;
+    int cores = 0;
+};
+
+// Every loaded core: its name and content hash, and its Ls and Rs channels.
+// The graph of core i is found through the graph registry, MainWindow::coreGraph(useLsData, i).
+class CoreDataset
+{
+public:
+    void clear();
+
+    int coreCount() const { return names.size(); }
+    bool isEmpty() const { return names.isEmpty(); }
+
+    const QString &name(int core) const { return names[core]; }
+    quint64 contentHash(int core) const { return hashes[core]; }
+
+    ChannelMatrix &channel(bool useLsData) { return useLsData ? lsChannel : rsChannel; }
+    const ChannelMatrix &channel(bool useLsData) const { return useLsData ? lsChannel : rsChannel; }
+
+    // false when the core store cannot grow, see ChannelMatrix
+    bool appendCore(const QString &name);
+    bool setCore(int core, const CsvParseResult &parsed);
+    void clearCore(int core);
+
+    // Drop the cores whose keep flag is false, the later ones move down in one pass
+    void removeCores(const QVector<bool> &keep);
+
+private:
+    QStringList names;
+    QVector<quint64> hashes;
+    ChannelMatrix lsChannel;
+    ChannelMatrix rsChannel;
+};
+
+// Files of a load batch in the order they may go into the dataset. Until the batch is released
+// they are handed out in slot order only, so the lowest slot makes the grid of a channel and the
+// grid does not depend on which file finishes parsing first; after that as they arrive.
+class BatchOrder
+{
+public:
+    void reset(int count);
+
+    // File index is parsed, returns the files that can be set now in slot order
+    QVector<int> arrive(int index);
+
+    // Every channel has its grid, returns the files held back in slot order
+    QVector<int> release();
+    bool isReleased() const { return released; }
+
+private:
+    QVector<bool> arrived;
+    int next = 0;	// Lowest file not handed out yet
+    bool released = false;
+};
+
+#endif // COREDATASET_H
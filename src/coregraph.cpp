@@ -0,0 +1,557 @@
+/**
+ *@file coregraph.cpp
+ *@brief Implementation of the core graph that plots a core straight from the dataset store
+ *
+ *This file contains the implementation of the QCPGraph subclass used for the core graphs. A
+ *core graph reads its keys from the frequency grid of the channel matrix and its values from
+ *the row of its core, so creating the graph of a core copies nothing and costs the same for
+ *one core or a thousand. Drawing, the 1D data interface, the selection hit test and the axis
+ *ranges all work on the row; only the points on screen are turned into pixel coordinates. When
+ *zoomed out the points come from the level of the core's min/max pyramid that has about one
+ *bucket per pixel column, so a frame costs the pixels of the graph and not the points of the core.
+ *
+ *@note A core graph keeps no copy of its data, setSource has to follow its core when slots move.
+ *
+ *@date[10/16/26]
+ */
+#include "coregraph.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    inline bool matchesSignDomain(double value, QCP::SignDomain signDomain)
+    {
+        return signDomain == QCP::sdBoth ||
+               (signDomain == QCP::sdNegative && value < 0.0) ||
+               (signDomain == QCP::sdPositive && value > 0.0);
+    }
+
+    inline void extend(QCPRange &range, bool &foundRange, double value)
+    {
+        if (!foundRange)
+        {
+            range.lower = value;
+            range.upper = value;
+            foundRange = true;
+        }
+        else if (value < range.lower)
+        {
+            range.lower = value;
+        }
+        else if (value > range.upper)
+        {
+            range.upper = value;
+        }
+    }
+}
+
+CoreGraph::CoreGraph(QCPAxis *keyAxis, QCPAxis *valueAxis):
+    QCPGraph(keyAxis, valueAxis)
+{
+}
+
+// Core row of the matrix shown by this graph, the graph keeps the pointer only
+void CoreGraph::setSource(const ChannelMatrix *matrix, int core)
+{
+    sourceMatrix = matrix;
+    sourceCore = core;
+}
+
+// Grid and row of the core, false while the core is not in the matrix
+bool CoreGraph::view(ColumnSpan &keys, ColumnSpan &values) const
+{
+    if (sourceMatrix == nullptr || sourceCore < 0 || sourceCore >= sourceMatrix->coreCount())
+    {
+        return false;
+    }
+
+    keys = sourceMatrix->frequencies();
+    values = sourceMatrix->core(sourceCore);
+    return !values.isEmpty();
+}
+
+int CoreGraph::dataCount() const
+{
+    ColumnSpan keys, values;
+    return view(keys, values) ? values.size() : QCPGraph::dataCount();
+}
+
+double CoreGraph::dataMainKey(int index) const
+{
+    ColumnSpan keys, values;
+    return view(keys, values) ? keys[index] : QCPGraph::dataMainKey(index);
+}
+
+double CoreGraph::dataSortKey(int index) const
+{
+    return dataMainKey(index);
+}
+
+double CoreGraph::dataMainValue(int index) const
+{
+    ColumnSpan keys, values;
+    return view(keys, values) ? values[index] : QCPGraph::dataMainValue(index);
+}
+
+QCPRange CoreGraph::dataValueRange(int index) const
+{
+    ColumnSpan keys, values;
+    if (!view(keys, values))
+    {
+        return QCPGraph::dataValueRange(index);
+    }
+
+    return QCPRange(values[index], values[index]);
+}
+
+QPointF CoreGraph::dataPixelPosition(int index) const
+{
+    ColumnSpan keys, values;
+    if (!view(keys, values))
+    {
+        return QCPGraph::dataPixelPosition(index);
+    }
+
+    return coordsToPixels(keys[index], values[index]);
+}
+
+// Same rules as QCPDataContainer::findBegin and findEnd, on the sorted grid
+int CoreGraph::findBegin(double sortKey, bool expandedRange) const
+{
+    ColumnSpan keys, values;
+    if (!view(keys, values))
+    {
+        return QCPGraph::findBegin(sortKey, expandedRange);
+    }
+
+    int index = std::lower_bound(keys.begin(), keys.end(), sortKey) - keys.begin();
+    if (expandedRange && index > 0)
+    {
+        --index;
+    }
+
+    return index;
+}
+
+int CoreGraph::findEnd(double sortKey, bool expandedRange) const
+{
+    ColumnSpan keys, values;
+    if (!view(keys, values))
+    {
+        return QCPGraph::findEnd(sortKey, expandedRange);
+    }
+
+    int index = std::upper_bound(keys.begin(), keys.end(), sortKey) - keys.begin();
+    if (expandedRange && index < keys.size())
+    {
+        ++index;
+    }
+
+    return index;
+}
+
+// Distance from pos to the closest point or line segment, as QCPGraph::pointDistance measures it
+double CoreGraph::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
+{
+    ColumnSpan keys, values;
+    if (!view(keys, values))
+    {
+        return QCPGraph::selectTest(pos, onlySelectable, details);
+    }
+
+    if ((onlySelectable && mSelectable == QCP::stNone) || !mKeyAxis || !mValueAxis)
+        return -1;
+    if (mLineStyle == lsNone && mScatterStyle.isNone())
+        return -1;
+    if (!mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint()) && !mParentPlot->interactions().testFlag(QCP::iSelectPlottablesBeyondAxisRect))
+        return -1;
+
+    // Only the points within the selection tolerance of pos can be the closest one
+    double tolerance = mParentPlot->selectionTolerance();
+    double posKeyMin, posKeyMax, dummy;
+    pixelsToCoords(pos - QPointF(tolerance, tolerance), posKeyMin, dummy);
+    pixelsToCoords(pos + QPointF(tolerance, tolerance), posKeyMax, dummy);
+    if (posKeyMin > posKeyMax)
+    {
+        qSwap(posKeyMin, posKeyMax);
+    }
+
+    int begin = findBegin(posKeyMin, true);
+    int end = findEnd(posKeyMax, true);
+    double minDistSqr = std::numeric_limits<double>::max();
+    int closest = qMin(begin, values.size() - 1);
+    for (int i = begin; i < end; ++i)
+    {
+        if (qIsNaN(values[i]))
+        {
+            continue;
+        }
+
+        double distSqr = QCPVector2D(coordsToPixels(keys[i], values[i]) - pos).lengthSquared();
+        if (distSqr < minDistSqr)
+        {
+            minDistSqr = distSqr;
+            closest = i;
+        }
+    }
+
+    // A steep segment can pass closer than any point near pos
+    if (mLineStyle != lsNone)
+    {
+        QVector<QPointF> lines = linePoints(keys, values, QCPDataRange(0, values.size()));
+        QCPVector2D point(pos);
+        int step = mLineStyle == lsImpulse ? 2 : 1;
+        for (int i = 0; i < lines.size() - 1; i += step)
+        {
+            minDistSqr = qMin(minDistSqr, point.distanceSquaredToLine(lines.at(i), lines.at(i + 1)));
+        }
+    }
+
+    if (minDistSqr == std::numeric_limits<double>::max())
+    {
+        return -1;
+    }
+
+    if (details)
+    {
+        details->setValue(QCPDataSelection(QCPDataRange(closest, closest + 1)));
+    }
+
+    return qSqrt(minDistSqr);
+}
+
+QCPRange CoreGraph::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const
+{
+    ColumnSpan keys, values;
+    if (!view(keys, values))
+    {
+        return QCPGraph::getKeyRange(foundRange, inSignDomain);
+    }
+
+    QCPRange range;
+    foundRange = false;
+    for (int i = 0; i < values.size(); ++i)
+    {
+        if (!qIsNaN(values[i]) && matchesSignDomain(keys[i], inSignDomain))
+        {
+            extend(range, foundRange, keys[i]);
+        }
+    }
+
+    return range;
+}
+
+QCPRange CoreGraph::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+    ColumnSpan keys, values;
+    if (!view(keys, values))
+    {
+        return QCPGraph::getValueRange(foundRange, inSignDomain, inKeyRange);
+    }
+
+    int begin = 0;
+    int end = values.size();
+    if (inKeyRange != QCPRange())
+    {
+        begin = findBegin(inKeyRange.lower, false);
+        end = findEnd(inKeyRange.upper, false);
+    }
+
+    QCPRange range;
+    foundRange = false;
+    for (int i = begin; i < end; ++i)
+    {
+        if (!qIsNaN(values[i]) && matchesSignDomain(values[i], inSignDomain))
+        {
+            extend(range, foundRange, values[i]);
+        }
+    }
+
+    return range;
+}
+
+// Same passes as QCPGraph::draw, with the points taken from the matrix row
+void CoreGraph::draw(QCPPainter *painter)
+{
+    ColumnSpan keys, values;
+    if (!view(keys, values))
+    {
+        QCPGraph::draw(painter);
+        return;
+    }
+
+    if (!mKeyAxis || !mValueAxis || mKeyAxis.data()->range().size() <= 0)
+        return;
+    if (mLineStyle == lsNone && mScatterStyle.isNone())
+        return;
+
+    QList<QCPDataRange> selectedSegments, unselectedSegments, allSegments;
+    getDataSegments(selectedSegments, unselectedSegments);
+    allSegments << unselectedSegments << selectedSegments;
+    for (int i = 0; i < allSegments.size(); ++i)
+    {
+        bool isSelectedSegment = i >= unselectedSegments.size();
+
+        // Unselected segments reach the bordering selected point
+        QCPDataRange lineDataRange = isSelectedSegment ? allSegments.at(i) : allSegments.at(i).adjusted(-1, 1);
+        QVector<QPointF> lines = linePoints(keys, values, lineDataRange);
+
+        // Fill
+        if (isSelectedSegment && mSelectionDecorator)
+            mSelectionDecorator->applyBrush(painter);
+        else
+            painter->setBrush(mBrush);
+        painter->setPen(Qt::NoPen);
+        drawFill(painter, &lines);
+
+        // Line
+        if (mLineStyle != lsNone)
+        {
+            if (isSelectedSegment && mSelectionDecorator)
+                mSelectionDecorator->applyPen(painter);
+            else
+                painter->setPen(mPen);
+            painter->setBrush(Qt::NoBrush);
+            if (mLineStyle == lsImpulse)
+                drawImpulsePlot(painter, lines);
+            else
+                drawLinePlot(painter, lines);
+        }
+
+        // Scatters
+        QCPScatterStyle finalScatterStyle = mScatterStyle;
+        if (isSelectedSegment && mSelectionDecorator)
+            finalScatterStyle = mSelectionDecorator->getFinalScatterStyle(mScatterStyle);
+        if (!finalScatterStyle.isNone())
+        {
+            int begin, end;
+            visibleBounds(keys, allSegments.at(i), begin, end);
+            drawScatterPlot(painter, scatterPoints(keys, values, begin, end), finalScatterStyle);
+        }
+    }
+
+    if (mSelectionDecorator)
+        mSelectionDecorator->drawDecoration(painter, selection());
+}
+
+// Points on screen plus one on either side so lines leave the axis rect, limited to dataRange
+void CoreGraph::visibleBounds(const ColumnSpan &keys, const QCPDataRange &dataRange, int &begin, int &end) const
+{
+    QCPRange range = mKeyAxis->range();
+    begin = int(std::lower_bound(keys.begin(), keys.end(), range.lower) - keys.begin()) - 1;
+    end = int(std::upper_bound(keys.begin(), keys.end(), range.upper) - keys.begin()) + 1;
+
+    begin = qMax(begin, qMax(dataRange.begin(), 0));
+    end = qMin(end, qMin(dataRange.end(), keys.size()));
+    end = qMax(begin, end);
+}
+
+// Length of the key axis in pixels
+int CoreGraph::keyPixels() const
+{
+    QCPAxisRect *axisRect = mKeyAxis->axisRect();
+    return mKeyAxis->orientation() == Qt::Horizontal ? axisRect->width() : axisRect->height();
+}
+
+// Coarsest pyramid level that still has a bucket for every pixel column, -1 when none does
+int CoreGraph::pyramidLevel(int points) const
+{
+    int pixels = keyPixels();
+    int level = -1;
+    while (level + 1 < sourceMatrix->pyramidLevels() && points / ChannelMatrix::bucketSize(level + 1) >= pixels)
+    {
+        ++level;
+    }
+
+    return level;
+}
+
+// Low and high of the pyramid buckets covering begin to end, at the key in the middle of each bucket
+QVector<QCPGraphData> CoreGraph::bucketData(const ColumnSpan &keys, int level, int begin, int end) const
+{
+    const double *buckets = sourceMatrix->pyramid(sourceCore, level);
+    int size = ChannelMatrix::bucketSize(level);
+    int first = begin / size;
+    int last = (end - 1) / size;
+
+    QVector<QCPGraphData> data;
+    data.reserve(2 * (last - first + 1));
+    for (int j = first; j <= last; ++j)
+    {
+        double key = keys[qMin(j * size + size / 2, keys.size() - 1)];
+        double low = buckets[2 * j];
+        double high = buckets[2 * j + 1];
+
+        // A bucket without values breaks the line like a NaN point
+        if (qIsNaN(low))
+        {
+            data.append(QCPGraphData(key, low));
+            continue;
+        }
+
+        // Start from the end nearer the previous point so the line does not zigzag
+        if (!data.isEmpty() && qAbs(data.last().value - high) < qAbs(data.last().value - low))
+        {
+            qSwap(low, high);
+        }
+
+        data.append(QCPGraphData(key, low));
+        if (high != low)
+        {
+            data.append(QCPGraphData(key, high));
+        }
+    }
+
+    return data;
+}
+
+// Points between begin and end. Zoomed out they come from the pyramid; between two and four points
+// per pixel a pixel column keeps its first, lowest, highest and last point.
+QVector<QCPGraphData> CoreGraph::lineData(const ColumnSpan &keys, const ColumnSpan &values, int begin, int end) const
+{
+    QVector<QCPGraphData> data;
+    int pixels = keyPixels();
+
+    if (end - begin <= 2 * pixels)
+    {
+        data.resize(end - begin);
+        for (int i = begin; i < end; ++i)
+        {
+            data[i - begin].key = keys[i];
+            data[i - begin].value = values[i];
+        }
+
+        return data;
+    }
+
+    int level = pyramidLevel(end - begin);
+    if (level >= 0)
+    {
+        return bucketData(keys, level, begin, end);
+    }
+
+    data.reserve(4 * pixels + 4);
+    int i = begin;
+    while (i < end)
+    {
+        // NaN points stay in, they break the line as QCPGraph does
+        if (qIsNaN(values[i]))
+        {
+            data.append(QCPGraphData(keys[i], values[i]));
+            ++i;
+            continue;
+        }
+
+        double column = std::floor(mKeyAxis->coordToPixel(keys[i]));
+        int first = i;
+        int low = i;
+        int high = i;
+        for (++i; i < end && !qIsNaN(values[i]) && std::floor(mKeyAxis->coordToPixel(keys[i])) == column; ++i)
+        {
+            if (values[i] < values[low])
+                low = i;
+            else if (values[i] > values[high])
+                high = i;
+        }
+
+        int last = i - 1;
+        int lower = qMin(low, high);
+        int upper = qMax(low, high);
+        data.append(QCPGraphData(keys[first], values[first]));
+        if (lower != first && lower != last)
+        {
+            data.append(QCPGraphData(keys[lower], values[lower]));
+        }
+
+        if (upper != lower && upper != first && upper != last)
+        {
+            data.append(QCPGraphData(keys[upper], values[upper]));
+        }
+
+        if (last != first)
+        {
+            data.append(QCPGraphData(keys[last], values[last]));
+        }
+    }
+
+    return data;
+}
+
+// Pixel points of the line style for the points of dataRange
+QVector<QPointF> CoreGraph::linePoints(const ColumnSpan &keys, const ColumnSpan &values, const QCPDataRange &dataRange) const
+{
+    if (mLineStyle == lsNone)
+    {
+        return QVector<QPointF> ();
+    }
+
+    int begin, end;
+    visibleBounds(keys, dataRange, begin, end);
+    QVector<QCPGraphData> data = lineData(keys, values, begin, end);
+
+    // Key pixels must ascend, as QCPGraph::getLines makes sure of
+    if (mKeyAxis->rangeReversed() != (mKeyAxis->orientation() == Qt::Vertical))
+    {
+        std::reverse(data.begin(), data.end());
+    }
+
+    switch (mLineStyle)
+    {
+        case lsStepLeft:
+            return dataToStepLeftLines(data);
+        case lsStepRight:
+            return dataToStepRightLines(data);
+        case lsStepCenter:
+            return dataToStepCenterLines(data);
+        case lsImpulse:
+            return dataToImpulseLines(data);
+        default:
+            return dataToLines(data);
+    }
+}
+
+// Scatter pixel points, skipping NaN, the scatter skip and points on the pixel of the previous one.
+// Zoomed out the low and high of each pyramid bucket get a scatter instead of every point.
+QVector<QPointF> CoreGraph::scatterPoints(const ColumnSpan &keys, const ColumnSpan &values, int begin, int end) const
+{
+    QVector<QPointF> scatters;
+    auto add = [&](double key, double value)
+    {
+        if (qIsNaN(value))
+        {
+            return;
+        }
+
+        QPointF point = coordsToPixels(key, value);
+        if (!scatters.isEmpty() && qAbs(point.x() - scatters.last().x()) < 1.0 && qAbs(point.y() - scatters.last().y()) < 1.0)
+        {
+            return;
+        }
+
+        scatters.append(point);
+    };
+
+    int level = end - begin > 2 * keyPixels() ? pyramidLevel(end - begin) : -1;
+    if (level >= 0)
+    {
+        const QVector<QCPGraphData> data = bucketData(keys, level, begin, end);
+        scatters.reserve(data.size());
+        for (const QCPGraphData &point: data)
+        {
+            add(point.key, point.value);
+        }
+
+        return scatters;
+    }
+
+    scatters.reserve(end - begin);
+    int step = mScatterSkip + 1;
+    for (int i = begin; i < end; i += step)
+    {
+        add(keys[i], values[i]);
+    }
+
+    return scatters;
+}
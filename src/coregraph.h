@@ -0,0 +1,51 @@
+#ifndef COREGRAPH_H
+#define COREGRAPH_H
+
+#include "qcustomplot.h"
+#include "coredataset.h"
+
+// Graph of one core that draws straight from its row of the channel matrix, so no
+// QCPGraphData copy of the core is made. Until the core is in the matrix (a streamed file
+// still loading, a slot cleared as a duplicate) it draws its own data container instead.
+class CoreGraph : public QCPGraph
+{
+    Q_OBJECT
+
+public:
+    CoreGraph(QCPAxis *keyAxis, QCPAxis *valueAxis);
+
+    void setSource(const ChannelMatrix *matrix, int core);
+    int core() const { return sourceCore; }
+
+    // QCPPlottableInterface1D over the matrix row
+    int dataCount() const override;
+    double dataMainKey(int index) const override;
+    double dataSortKey(int index) const override;
+    double dataMainValue(int index) const override;
+    QCPRange dataValueRange(int index) const override;
+    QPointF dataPixelPosition(int index) const override;
+    int findBegin(double sortKey, bool expandedRange = true) const override;
+    int findEnd(double sortKey, bool expandedRange = true) const override;
+
+    double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details = nullptr) const override;
+    QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth) const override;
+    QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth, const QCPRange &inKeyRange = QCPRange()) const override;
+
+protected:
+    void draw(QCPPainter *painter) override;
+
+private:
+    bool view(ColumnSpan &keys, ColumnSpan &values) const;
+    void visibleBounds(const ColumnSpan &keys, const QCPDataRange &dataRange, int &begin, int &end) const;
+    int keyPixels() const;
+    int pyramidLevel(int points) const;
+    QVector<QCPGraphData> bucketData(const ColumnSpan &keys, int level, int begin, int end) const;
+    QVector<QCPGraphData> lineData(const ColumnSpan &keys, const ColumnSpan &values, int begin, int end) const;
+    QVector<QPointF> linePoints(const ColumnSpan &keys, const ColumnSpan &values, const QCPDataRange &dataRange) const;
+    QVector<QPointF> scatterPoints(const ColumnSpan &keys, const ColumnSpan &values, int begin, int end) const;
+
+    const ChannelMatrix *sourceMatrix = nullptr;
+    int sourceCore = -1;
+};
+
+#endif // COREGRAPH_H
@@ -15,11 +15,47 @@
  */
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "csvparser.h"
+#include "csvcache.h"
+#include "tararchive.h"
 #include <QMessageBox>
+#include <QVBoxLayout>
+#include <QTableWidget>
+#include <QLabel>
+#include <QSet>
+#include <QtConcurrent>
+#include <QSemaphore>
+#include <QPromise>
+#include <numeric>
+#include <algorithm>
+
+// Files above this size are streamed in chunks instead of being mapped as a whole
+static const qint64 csvStreamingThreshold = 256 * 1024 * 1024;
+static const qint64 csvStreamingChunkBytes = 4 * 1024 * 1024;
+static const int csvStreamingChunksInFlight = 4;
+static const int csvPreviewBucketRows = 64;	// A streamed chunk is previewed by the low and high of every bucket
+
+// Binary copies of imported files are kept up to this size, least recently used first out
+static const qint64 csvCacheSizeLimit = qint64(4) * 1024 * 1024 * 1024;
+
+// One sweep to parse: a file on disk or a member of a tar bundle
+struct CsvSource
+{
+    QString filePath;	// Bundle members are shown as bundle/member
+    QString name;
+    QSharedPointer<TarArchive> archive;
+    TarMember member;
+};
 
 // Button -> Load CSV
 void MainWindow::on_btn_load_plot_clicked()
 {
+    // A batch is still being read or parsed
+    if (csvIndexWatcher != nullptr || csvLoadWatcher != nullptr)
+    {
+        return;
+    }
+
     clearEverything();
 
     if (!checkAndSetInitialValues())
@@ -29,140 +65,687 @@ void MainWindow::on_btn_load_plot_clicked()
         return;
     }
 
-    QStringList fileNames = QFileDialog::getOpenFileNames(this, "Select CSV Files", "", "CSV Files (*.csv)");
+    QStringList fileNames = QFileDialog::getOpenFileNames(this, "Select CSV Files", "", "CSV Files (*.csv *.csv.gz *.tar *.tar.gz *.tgz)");
     qDebug() << "Dosya isimleri" << fileNames;
-    for (const QString &fileName: fileNames)
+
+    if (fileNames.isEmpty())
     {
-        QFile file(fileName);
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text))
-        {
-            QTextStream in (&file);
+        return;
+    }
+
+    loadCsvFiles(fileNames);
+}
+
+// Button -> Add CSV Files, keeps the loaded cores and appends the new ones
+void MainWindow::on_btn_add_plot_clicked()
+{
+    // A batch is still being read or parsed
+    if (csvIndexWatcher != nullptr || csvLoadWatcher != nullptr)
+    {
+        return;
+    }
+
+    // Nothing to add to yet
+    if (dataset.isEmpty())
+    {
+        on_btn_load_plot_clicked();
+        return;
+    }
+
+    if (!checkAndSetInitialValues())
+    {
+        QMessageBox::information(this, "Info", "Please set frequency range values in the settings tab.");
+        return;
+    }
+
+    QStringList fileNames = QFileDialog::getOpenFileNames(this, "Add CSV Files", "", "CSV Files (*.csv *.csv.gz *.tar *.tar.gz *.tgz)");
+    if (fileNames.isEmpty())
+    {
+        return;
+    }
+
+    // The average graph sits behind the cores, it comes back once the new cores are in
+    removeAverageGraphs();
+
+    loadCsvFiles(fileNames);
+}
+
+// Parse fileNames in the background into new slots behind the loaded cores, a tar bundle adds one per sweep file
+void MainWindow::loadCsvFiles(const QStringList &fileNames)
+{
+    csvLoadFirstSlot = dataset.coreCount();
+    csvLoadDiagnostics.clear();
+
+    // Progress Dialog, shared by reading the bundles and parsing the files
+    csvLoadProgress = new QProgressDialog("Reading archives...", "Cancel", 0, fileNames.size(), this);
+    csvLoadProgress->setWindowModality(Qt::WindowModal);
+    csvLoadProgress->setMinimumDuration(0);
+    csvLoadProgress->setValue(0);
+    connect(csvLoadProgress, &QProgressDialog::canceled, this, &MainWindow::cancelCsvLoad);
+
+    csvLoadCancelled = QSharedPointer<QAtomicInt>::create(0);
+    QSharedPointer<QAtomicInt> cancelled = csvLoadCancelled;
 
-            // Skip the first row (header: "FREQUENCY,Ls,Rs")
-            in .readLine();
+    // Bundles are indexed on a worker so every member gets its own slot, a compressed one has to be
+    // inflated to find its members; the members themselves are read while they are parsed
+    QSharedPointer<QVector<CsvSource>> sources = QSharedPointer<QVector<CsvSource>>::create();
+    QSharedPointer<QVector<CsvDiagnostic>> diagnostics = QSharedPointer<QVector<CsvDiagnostic>>::create();
 
-            QVector<double> lsValues;
-            QVector<double> rsValues;
-            QVector<double> frequenciesRs;
-            QVector<double> frequenciesLs;
+    csvIndexWatcher = new QFutureWatcher<void> (this);
 
-            while (! in .atEnd())
+    connect(csvIndexWatcher, &QFutureWatcher<void>::progressValueChanged, csvLoadProgress, &QProgressDialog::setValue);
+    connect(csvIndexWatcher, &QFutureWatcher<void>::progressTextChanged, csvLoadProgress, &QProgressDialog::setLabelText);
+    connect(csvIndexWatcher, &QFutureWatcher<void>::finished, this, [this, sources, diagnostics]()
             {
-                QString line = in .readLine();
-                QStringList data = line.split(",");
+                csvIndexWatcher->deleteLater();
+                csvIndexWatcher = nullptr;
 
-                if (data.size() >= 3)
+                // A cancelled batch still goes through the parse step so it is finished the usual way
+                csvLoadDiagnostics += *diagnostics;
+                if (csvLoadCancelled->loadRelaxed())
                 {
-                    // Read the FREQUENCY, Ls, and Rs values
-                    bool ok;
-                    double frequency = data[0].toDouble(&ok);
-                    double frequencyLs = data[0].toDouble(&ok);
-                    double frequencyRs = data[0].toDouble(&ok);
-                    double lsValue = data[1].toDouble(&ok);
-                    double rsValue = data[2].toDouble(&ok);
-
-                    if (ok)
-                    {
-                        if (frequency >= minFrequencyLS && frequency <= maxFrequencyLS)
-                        {
-                            frequenciesLs.append(frequencyLs);
-                            lsValues.append(lsValue);
-                            // rsValues.append(rsValue);
-
-                            qDebug() << "Appended this LS VALUE: " << frequencyLs << " " << lsValue;
-                        }
-
-                        if (frequency >= minFrequencyRS && frequency <= maxFrequencyRS)
-                        {
-                            frequenciesRs.append(frequencyRs);
-                            rsValues.append(rsValue);
-                            // rsValues.append(rsValue);
-
-                            qDebug() << "Appended this RS VALUE: " << frequencyRs << " " << rsValue;
-                        }
-                    }
-                    else
-                    {
-                        QMessageBox::warning(this, "Warning", "CSV Files should be in this format: FREQUENCY,LS,RS.");
-
-                        qDebug() << "Error reading values in line: " << line;
-                        return;
-                    }
+                    sources->clear();
                 }
-                else
-                {
-                    QMessageBox::warning(this, "Warning", "CSV Files should be in this format: FREQUENCY,LS,RS.");
-
-                    qDebug() << "Invalid line format: " << line;
-                    return;
-                }
-            }
 
-            qDebug() << "Reading is done.";
-
-            file.close();
+                parseCsvSources(*sources);
+            });
+
+    csvIndexWatcher->setFuture(QtConcurrent::run([fileNames, sources, diagnostics, cancelled](QPromise<void> &promise)
+                                                 {
+                                                     promise.setProgressRange(0, fileNames.size());
+                                                     for (int i = 0; i < fileNames.size() && !cancelled->loadRelaxed(); ++i)
+                                                     {
+                                                         const QString &fileName = fileNames[i];
+                                                         if (!TarArchive::isArchive(fileName))
+                                                         {
+                                                             CsvSource source;
+                                                             source.filePath = fileName;
+                                                             source.name = QFileInfo(fileName).baseName();
+                                                             sources->append(source);
+                                                             promise.setProgressValue(i + 1);
+                                                             continue;
+                                                         }
+
+                                                         promise.setProgressValueAndText(i, QString("Reading %1...").arg(QFileInfo(fileName).fileName()));
+
+                                                         QSharedPointer<TarArchive> archive = QSharedPointer<TarArchive>::create(fileName, ".csv");
+                                                         if (!archive->open(cancelled.data()))
+                                                         {
+                                                             CsvDiagnostic diagnostic;
+                                                             diagnostic.filePath = fileName;
+                                                             diagnostic.reason = archive->errorString();
+                                                             diagnostics->append(diagnostic);
+                                                             continue;
+                                                         }
+
+                                                         for (const TarMember &member: archive->members())
+                                                         {
+                                                             CsvSource source;
+                                                             source.filePath = fileName + '/' + member.path;
+                                                             source.name = member.path.chopped(4);	// Member path without ".csv"
+                                                             source.archive = archive;
+                                                             source.member = member;
+                                                             sources->append(source);
+                                                         }
+
+                                                         promise.setProgressValue(i + 1);
+                                                     }
+                                                 }));
+}
 
-            // Add data to the plot as a new CSVInfo entry  LS
-            CSVInfo fileInfo;
-            fileInfo.fileName = QFileInfo(fileName).baseName();
-            fileInfo.frequenciesLs = frequenciesLs;
-            fileInfo.lsValues = lsValues;
-            // fileInfo.rsValues = rsValues;
-            fileInfo.visible = true;	// Set visible to true initially
+// The bundles are indexed, parse every source into its own slot
+void MainWindow::parseCsvSources(QVector<CsvSource> sources)
+{
+    // A new session puts its cores on the grid picked in the settings, over each channel's window
+    if (csvLoadFirstSlot == 0)
+    {
+        GridOptions options;
+        options.spacing = gridSpacing;
+        options.interpolation = gridInterpolation;
 
-            qDebug() << "Append this file: " << fileInfo.fileName;
-            loadedCSVLS.append(fileInfo);
+        options.minFrequency = minFrequencyLS;
+        options.maxFrequency = maxFrequencyLS;
+        dataset.channel(true).setGridOptions(options);
 
-            // Add data to the plot as a new CSVInfo2 entry for RS
-            CSVInfo2 fileInfo2RS;
-            fileInfo2RS.fileName = QFileInfo(fileName).baseName();
-            fileInfo2RS.frequenciesRs = frequenciesRs;
-            fileInfo2RS.rsValues = rsValues;
-            fileInfo2RS.visible = true;
+        options.minFrequency = minFrequencyRS;
+        options.maxFrequency = maxFrequencyRS;
+        dataset.channel(false).setGridOptions(options);
+    }
 
-            qDebug() << "Append this file: " << fileInfo2RS.fileName;
-            loadedCSVRS.append(fileInfo2RS);
+    // Reserve one slot per file so the cores keep the order the user picked
+    for (int i = 0; i < sources.size(); ++i)
+    {
+        if (!dataset.appendCore(sources[i].name))
+        {
+            // The temporary disk is full, the files that got a slot are still loaded
+            CsvDiagnostic diagnostic;
+            diagnostic.filePath = sources[i].filePath;
+            diagnostic.reason = QString("Core store could not grow, this and the %1 files after it were not loaded").arg(sources.size() - i - 1);
+            csvLoadDiagnostics.append(diagnostic);
+            sources.resize(i);
+            break;
         }
-        else
+    }
+
+    // Sweeps already in the session, a new file with the same content is skipped
+    csvLoadHashes.clear();
+    csvLoadDuplicates = 0;
+    for (int i = 0; i < csvLoadFirstSlot; ++i)
+    {
+        if (dataset.channel(true).hasCore(i) || dataset.channel(false).hasCore(i))
         {
-            QMessageBox::warning(this, "Warning", "Failed to open the file.");
-            return;
-            qDebug() << "Failed to open the file: " << fileName;
+            csvLoadHashes.insert(dataset.contentHash(i), i);
         }
     }
 
-    // Update the plot based on the selected mode (LS or RS)
-    if (ui->radioButton_Ls->isChecked())
+    csvLoaded = QVector<bool> (sources.size(), false);
+    csvLoadOrder.reset(sources.size());
+    if (hasCoreGrids())
+    {
+        csvLoadOrder.release();
+    }
+
+    csvLoadBytes = 0;
+    csvLoadTimer.start();
+
+    // Create the (still empty) graphs of both channels, they are filled as the files finish
+    addCoreGraphs(csvLoadFirstSlot);
+    if (csvLoadFirstSlot == 0 && ui->radioButton_Ls->isChecked())
     {
         on_radioButton_Ls_clicked();
     }
-    else if (ui->radioButton_Rs->isChecked())
+    else if (csvLoadFirstSlot == 0 && ui->radioButton_Rs->isChecked())
     {
         on_radioButton_Rs_clicked();
     }
+
+    // Progress Dialog
+    csvLoadProgress->setLabelText("Loading CSV files...");
+    csvLoadProgress->setRange(0, sources.size());
+    csvLoadProgress->setValue(0);
+
+    // Parse the files on the global thread pool
+    CsvParser parser(minFrequencyLS, maxFrequencyLS, minFrequencyRS, maxFrequencyRS);
+
+    // Binary copies of already imported files
+    QString cachePath = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/whilone/csvcache";
+    QDir().mkpath(cachePath);
+    CsvCache cache(cachePath, parser);
+    cache.prune(csvCacheSizeLimit);
+    csvLoadCacheHits = 0;
+
+    // Streaming: at most a few parsed chunks wait for the GUI thread at any time
+    csvLoadChunkSlots = QSharedPointer<QSemaphore>::create(csvStreamingChunksInFlight);
+    QSharedPointer<QSemaphore> chunkSlots = csvLoadChunkSlots;
+    QSharedPointer<QAtomicInt> cancelled = csvLoadCancelled;
+
+    csvLoadWatcher = new QFutureWatcher<CsvParseResult> (this);
+
+    connect(csvLoadWatcher, &QFutureWatcher<CsvParseResult>::resultReadyAt, this, &MainWindow::onCsvFileParsed);
+    connect(csvLoadWatcher, &QFutureWatcher<CsvParseResult>::finished, this, &MainWindow::onCsvLoadFinished);
+    connect(csvLoadWatcher, &QFutureWatcher<CsvParseResult>::progressValueChanged, csvLoadProgress, &QProgressDialog::setValue);
+
+    QVector<int> fileIndexes(sources.size());
+    std::iota(fileIndexes.begin(), fileIndexes.end(), 0);
+
+    csvLoadWatcher->setFuture(QtConcurrent::mapped(fileIndexes, [this, parser, cache, sources, chunkSlots, cancelled](int index)
+                                                   {
+                                                       const CsvSource &source = sources[index];
+                                                       if (source.archive && source.archive->isMapped())
+                                                       {
+                                                           // Straight from the mapped bundle, nothing is extracted
+                                                           return parser.parseMemory(source.filePath, source.archive->memberData(source.member), source.member.size);
+                                                       }
+
+                                                       if (source.archive)
+                                                       {
+                                                           // Inflated from a compressed bundle, only this member is held
+                                                           QByteArray contents;
+                                                           if (!source.archive->readMember(source.member, contents))
+                                                           {
+                                                               CsvParseResult failed;
+                                                               failed.filePath = source.filePath;
+                                                               failed.status = CsvParseResult::OpenFailed;
+                                                               return failed;
+                                                           }
+
+                                                           return parser.parseMemory(source.filePath, contents.constData(), contents.size());
+                                                       }
+
+                                                       const QString &fileName = source.filePath;
+
+                                                       CsvParseResult parsed;
+                                                       if (cache.load(fileName, parsed))
+                                                       {
+                                                           return parsed;
+                                                       }
+
+                                                       if (QFileInfo(fileName).size() > csvStreamingThreshold)
+                                                       {
+                                                           // Plot the rows while the rest of the file is still being read
+                                                           parsed = parser.parseStream(fileName, csvStreamingChunkBytes, [this, index, chunkSlots, cancelled](const CoreColumns &chunk)
+                                                                                       {
+                                                                                           chunkSlots->acquire();
+                                                                                           if (cancelled->loadRelaxed())
+                                                                                           {
+                                                                                               chunkSlots->release();
+                                                                                               return false;
+                                                                                           }
+
+                                                                                           QMetaObject::invokeMethod(this, [this, index, chunk, chunkSlots]()
+                                                                                                                     {
+                                                                                                                         onCsvChunkParsed(index, chunk);
+                                                                                                                         chunkSlots->release();
+                                                                                                                     }, Qt::QueuedConnection);
+                                                                                           return true;
+                                                                                       });
+                                                       }
+                                                       else
+                                                       {
+                                                           parsed = parser.parseFile(fileName);
+                                                       }
+
+                                                       cache.store(parsed);
+                                                       return parsed;
+                                                   }));
+
+    // Cancelled while the bundles were read
+    if (cancelled->loadRelaxed())
+    {
+        csvLoadWatcher->cancel();
+    }
 }
 
-// Button -> Export AVG as CSV
-void MainWindow::on_btn_export_avg_clicked()
+// Cancel button of the progress dialog, failed files only go into the import report
+void MainWindow::cancelCsvLoad()
 {
-    if (loadedCSVRS.isEmpty() && loadedCSVLS.isEmpty())
+    if (csvIndexWatcher == nullptr && csvLoadWatcher == nullptr)
     {
-        QMessageBox::warning(this, "Warning", "No CSV data loaded. Load CSV files first.");
         return;
     }
 
-    int averageGraphIndex = -1;
-    for (int i = 0; i < ui->Plot->graphCount(); ++i)
+    csvLoadCancelled->storeRelaxed(1);
+    if (csvLoadWatcher)
+    {
+        csvLoadWatcher->cancel();
+    }
+}
+
+// Cancel a running load and wait for its workers, nothing of the batch is taken into the session
+void MainWindow::stopCsvLoad()
+{
+    cancelCsvLoad();
+
+    // Reading the bundles stops at the next header
+    if (csvIndexWatcher)
+    {
+        csvIndexWatcher->waitForFinished();
+    }
+
+    if (csvLoadWatcher == nullptr)
     {
-        QCPGraph *graph = ui->Plot->graph(i);
-        if (graph && (graph->name() == "Average LS" || graph->name() == "Average RS"))
+        return;
+    }
+
+    // The queued chunks that would give their slots back are dropped with the window, workers
+    // waiting for a slot get one, see the cancel and stop
+    csvLoadChunkSlots->release(csvStreamingChunksInFlight - csvLoadChunkSlots->available());
+    csvLoadWatcher->waitForFinished();
+}
+
+// A chunk of a streamed file is parsed
+void MainWindow::onCsvChunkParsed(int index, const CoreColumns &chunk)
+{
+    // Only the rows inside the window of the channel on screen
+    bool useLsData = ui->radioButton_Ls->isChecked();
+    QCPGraph *graph = coreGraph(useLsData, csvLoadFirstSlot + index);
+    if (csvLoadWatcher == nullptr || graph == nullptr)
+    {
+        return;
+    }
+
+    double minFrequency = useLsData ? minFrequencyLS : minFrequencyRS;
+    double maxFrequency = useLsData ? maxFrequencyLS : maxFrequencyRS;
+    const QVector<double> &values = useLsData ? chunk.lsValues : chunk.rsValues;
+    ChannelSummary &summary = dataset.channel(useLsData).summary(csvLoadFirstSlot + index);
+
+    // The parser keeps the rows, the preview only needs their outline until the core is drawn from the matrix
+    QVector<QCPGraphData> points;
+    points.reserve(2 * (chunk.frequencies.size() / csvPreviewBucketRows + 1));
+    for (int bucket = 0; bucket < chunk.frequencies.size(); bucket += csvPreviewBucketRows)
+    {
+        int low = -1;
+        int high = -1;
+        int end = qMin(bucket + csvPreviewBucketRows, int(chunk.frequencies.size()));
+        for (int i = bucket; i < end; ++i)
         {
-            averageGraphIndex = i;
-            break;
+            double frequency = chunk.frequencies[i];
+            if (frequency >= minFrequency && frequency <= maxFrequency)
+            {
+                summary.add(frequency, values[i]);
+                low = (low < 0 || values[i] < values[low]) ? i : low;
+                high = (high < 0 || values[i] > values[high]) ? i : high;
+            }
+        }
+
+        // In frequency order so the preview line does not fold back
+        if (low >= 0)
+        {
+            points.append(QCPGraphData(chunk.frequencies[qMin(low, high)], values[qMin(low, high)]));
+            if (low != high)
+            {
+                points.append(QCPGraphData(chunk.frequencies[qMax(low, high)], values[qMax(low, high)]));
+            }
         }
     }
 
-    if (averageGraphIndex == -1)
+    graph->data()->add(points);
+
+    rescaleToCores(useLsData);
+    ui->Plot->replot(QCustomPlot::rpQueuedReplot);
+}
+
+// One file of the batch is parsed, it is set into its slot once the files before it are in or the grids are made
+void MainWindow::onCsvFileParsed(int index)
+{
+    for (int ready: csvLoadOrder.arrive(index))
+    {
+        setCsvFile(ready);
+    }
+
+    if (!csvLoadOrder.isReleased() && hasCoreGrids())
+    {
+        for (int ready: csvLoadOrder.release())
+        {
+            setCsvFile(ready);
+        }
+    }
+}
+
+// Both channels have the grid of the session
+bool MainWindow::hasCoreGrids() const
+{
+    return dataset.channel(true).frequencyCount() > 0 && dataset.channel(false).frequencyCount() > 0;
+}
+
+// Take a parsed file of the batch into the session
+void MainWindow::setCsvFile(int index)
+{
+    CsvParseResult parsed = csvLoadWatcher->resultAt(index);
+
+    // Bad rows and bad files go into the report, the rest of the batch keeps loading
+    csvLoadDiagnostics += parsed.diagnostics;
+
+    if (parsed.status == CsvParseResult::OpenFailed)
+    {
+        CsvDiagnostic diagnostic;
+        diagnostic.filePath = parsed.filePath;
+        diagnostic.reason = "Failed to open the file";
+        csvLoadDiagnostics.append(diagnostic);
+        return;
+    }
+
+    if (parsed.status != CsvParseResult::Ok)
+    {
+        return;
+    }
+
+    qDebug() << (parsed.fromCache ? "Cached" : "Parsed") << parsed.filePath << ":" << parsed.throughputMBps() << "MB/s";
+    csvLoadBytes += parsed.bytes;
+    if (parsed.fromCache)
+    {
+        ++csvLoadCacheHits;
+    }
+
+    // The same sweep picked twice or saved under another name is loaded once
+    int slot = csvLoadFirstSlot + index;
+    if (parsed.rowCount() > 0)
+    {
+        int heldSlot = csvLoadHashes.value(parsed.contentHash, -1);
+        if (heldSlot >= 0 && heldSlot < slot)
+        {
+            skipDuplicateCore(parsed.filePath, heldSlot);
+            return;
+        }
+
+        if (heldSlot >= 0)
+        {
+            // A later file of this batch finished first, the file picked first is the one kept
+            int heldIndex = heldSlot - csvLoadFirstSlot;
+            csvLoaded[heldIndex] = false;
+            dataset.clearCore(heldSlot);
+
+            for (QCPGraph *heldGraph: {coreGraph(true, heldSlot), coreGraph(false, heldSlot)})
+            {
+                if (heldGraph)
+                {
+                    heldGraph->data()->clear();
+                }
+            }
+
+            skipDuplicateCore(csvLoadWatcher->resultAt(heldIndex).filePath, slot);
+        }
+
+        csvLoadHashes.insert(parsed.contentHash, slot);
+    }
+
+    // Fill the slot reserved for this file, the parsed columns are dropped with the result
+    if (!dataset.setCore(slot, parsed))
+    {
+        // Only making the grid grows the store here, the rest of the batch is stopped
+        if (csvLoadHashes.value(parsed.contentHash, -1) == slot)
+        {
+            csvLoadHashes.remove(parsed.contentHash);
+        }
+
+        CsvDiagnostic diagnostic;
+        diagnostic.filePath = parsed.filePath;
+        diagnostic.reason = "Core store could not grow, the load was stopped";
+        csvLoadDiagnostics.append(diagnostic);
+        cancelCsvLoad();
+        return;
+    }
+
+    csvLoaded[index] = true;
+
+    // The core graph draws the core from the matrix from now on, points streamed into it are dropped
+    QCPGraph *graph = coreGraph(ui->radioButton_Ls->isChecked(), slot);
+    if (graph)
+    {
+        graph->data()->clear();
+
+        rescaleToCores(ui->radioButton_Ls->isChecked());
+        ui->Plot->replot(QCustomPlot::rpQueuedReplot);
+    }
+}
+
+// Whole batch is done or cancelled
+void MainWindow::onCsvLoadFinished()
+{
+    // Files held back behind a slower one, or behind one that was cancelled
+    for (int ready: csvLoadOrder.release())
+    {
+        setCsvFile(ready);
+    }
+
+    bool cancelled = csvLoadWatcher->isCanceled() || csvLoadCancelled->loadRelaxed();
+
+    csvLoadProgress->close();
+    csvLoadProgress->deleteLater();
+    csvLoadProgress = nullptr;
+    csvLoadWatcher->deleteLater();
+    csvLoadWatcher = nullptr;
+
+    // Drop the slots and graphs of files that were cancelled or could not be read
+    QVector<int> droppedSlots;
+    QVector<bool> keepSlots(dataset.coreCount(), true);
+    for (int i = 0; i < csvLoaded.size(); ++i)
+    {
+        if (!csvLoaded[i])
+        {
+            droppedSlots.append(csvLoadFirstSlot + i);
+            keepSlots[csvLoadFirstSlot + i] = false;
+        }
+    }
+
+    if (!droppedSlots.isEmpty())
+    {
+        dataset.removeCores(keepSlots);
+        removeCoreGraphs(droppedSlots);
+    }
+
+    // Core graphs after a dropped slot now show the core one row up
+    for (int i = csvLoadFirstSlot; i < dataset.coreCount(); ++i)
+    {
+        coreGraph(true, i)->setSource(&dataset.channel(true), i);
+        coreGraph(false, i)->setSource(&dataset.channel(false), i);
+    }
+
+    int newFiles = dataset.coreCount() - csvLoadFirstSlot;
+    csvLoaded.clear();
+
+    checkCoreSummaries(csvLoadFirstSlot);
+
+    // Added cores go into the existing average by delta instead of summing every core again
+    if (avg && csvLoadFirstSlot > 0)
+    {
+        for (int i = csvLoadFirstSlot; i < dataset.coreCount(); ++i)
+        {
+            averageSumsLs.add(dataset.channel(true).core(i));
+            averageSumsRs.add(dataset.channel(false).core(i));
+        }
+
+        bool useLsData = ui->radioButton_Ls->isChecked();
+        QVector<double> averageValues = useLsData ? averageSumsLs.average() : averageSumsRs.average();
+        addAverageGraph(averageValues, useLsData);
+        calculateDistanceRatios(averageValues);
+    }
+    else
+    {
+        rescaleToCores(ui->radioButton_Ls->isChecked());
+        ui->Plot->replot();
+    }
+
+    // Ingest throughput for the whole batch
+    qint64 elapsedNs = csvLoadTimer.nsecsElapsed();
+    if (elapsedNs > 0)
+    {
+        double throughput = (csvLoadBytes / 1e6) / (elapsedNs / 1e9);
+        ui->statusbar->showMessage(QString("Loaded %1 files (%2 MB, %3 from cache) at %4 MB/s%5%6")
+                                       .arg(newFiles)
+                                       .arg(csvLoadBytes / 1e6, 0, 'f', 1)
+                                       .arg(csvLoadCacheHits)
+                                       .arg(throughput, 0, 'f', 1)
+                                       .arg(csvLoadDuplicates > 0 ? QString(", %1 duplicates skipped").arg(csvLoadDuplicates) : QString())
+                                       .arg(cancelled ? " - cancelled" : ""));
+        qDebug() << "CSV ingest throughput:" << throughput << "MB/s";
+    }
+
+    if (!csvLoadDiagnostics.isEmpty())
+    {
+        showImportReport();
+    }
+}
+
+// A file whose kept rows, those inside the frequency windows, match keptSlot goes into the import
+// report instead of the session. Rows outside the windows or set aside as bad are not compared
+void MainWindow::skipDuplicateCore(const QString &filePath, int keptSlot)
+{
+    CsvDiagnostic diagnostic;
+    diagnostic.filePath = filePath;
+    diagnostic.reason = QString("Same data within the frequency windows as %1, skipped").arg(dataset.name(keptSlot));
+    csvLoadDiagnostics.append(diagnostic);
+    ++csvLoadDuplicates;
+}
+
+// Report cores from slot first on whose sweep does not cover the whole grid of a channel. Grid
+// points outside a sweep are NaN and are left out of the average, they are not extrapolated.
+void MainWindow::checkCoreSummaries(int first)
+{
+    const char *channels[] = { "LS", "RS" };
+    for (int i = first; i < dataset.coreCount(); ++i)
+    {
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            const ChannelMatrix &matrix = dataset.channel(channel == 0);
+            const QVector<double> &grid = matrix.frequencies();
+            if (grid.isEmpty() || !matrix.hasCore(i))
+            {
+                continue;
+            }
+
+            const ChannelSummary &summary = matrix.summary(i);
+            int covered = std::upper_bound(grid.begin(), grid.end(), summary.lastFrequency) -
+                          std::lower_bound(grid.begin(), grid.end(), summary.firstFrequency);
+            if (covered >= grid.size())
+            {
+                continue;
+            }
+
+            CsvDiagnostic diagnostic;
+            diagnostic.filePath = dataset.name(i);
+            diagnostic.reason = QString("%1 sweep from %2 to %3 covers %4 of the %5 grid points from %6 to %7, the others are left out of the average")
+                                    .arg(channels[channel])
+                                    .arg(summary.firstFrequency).arg(summary.lastFrequency)
+                                    .arg(qMax(covered, 0)).arg(grid.size())
+                                    .arg(grid.first()).arg(grid.last());
+            csvLoadDiagnostics.append(diagnostic);
+        }
+    }
+}
+
+// Table of every row and file left out of the last import
+void MainWindow::showImportReport()
+{
+    QDialog *reportDialog = new QDialog(this);
+    reportDialog->setAttribute(Qt::WA_DeleteOnClose);
+    reportDialog->setWindowTitle("Import Report");
+    reportDialog->resize(1000, 500);
+
+    QVBoxLayout *layout = new QVBoxLayout(reportDialog);
+
+    QSet<QString> files;
+    for (const CsvDiagnostic &diagnostic: csvLoadDiagnostics)
+    {
+        files.insert(diagnostic.filePath);
+    }
+
+    QLabel *summary = new QLabel(QString("%1 problems in %2 files. Everything else was loaded.").arg(csvLoadDiagnostics.size()).arg(files.size()), reportDialog);
+    layout->addWidget(summary);
+
+    QTableWidget *reportTable = new QTableWidget(csvLoadDiagnostics.size(), 3, reportDialog);
+    reportTable->setHorizontalHeaderLabels(QStringList() << "File" << "Line" << "Reason");
+    reportTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    // Adjust column widths
+    reportTable->setColumnWidth(0, 450);	// File
+    reportTable->setColumnWidth(1, 80);	// Line
+    reportTable->setColumnWidth(2, 400);	// Reason
+
+    for (int row = 0; row < csvLoadDiagnostics.size(); ++row)
+    {
+        const CsvDiagnostic &diagnostic = csvLoadDiagnostics[row];
+        reportTable->setItem(row, 0, new QTableWidgetItem(QDir::toNativeSeparators(diagnostic.filePath)));
+        reportTable->setItem(row, 1, new QTableWidgetItem(diagnostic.line > 0 ? QString::number(diagnostic.line) : "-"));
+        reportTable->setItem(row, 2, new QTableWidgetItem(diagnostic.reason));
+    }
+
+    layout->addWidget(reportTable);
+
+    reportDialog->setLayout(layout);
+    reportDialog->show();
+}
+
+// Button -> Export AVG as CSV
+void MainWindow::on_btn_export_avg_clicked()
+{
+    if (dataset.isEmpty())
+    {
+        QMessageBox::warning(this, "Warning", "No CSV data loaded. Load CSV files first.");
+        return;
+    }
+
+    if (averageGraph() == nullptr)
     {
         QMessageBox::warning(this, "Warning", "There is no Average Graph. Calculate Average Graph first.");
         return;	// Handle the case where the average graph is not found
@@ -212,20 +795,22 @@ void MainWindow::on_btn_export_avg_clicked()
 
         stream << "FREQUENCY,Ls,Rs\n";
 
-        // Write average graph data
+        // Write average graph data, on the grid shared by the cores
+        const QVector<double> &frequencies = dataset.channel(useLsData).frequencies();
+        int count = qMin(frequencies.size(), averageValues.size());
         if (useLsData)
         {
-            for (int i = 0; i < loadedCSVLS[0].frequenciesLs.size(); ++i)
+            for (int i = 0; i < count; ++i)
             {
-                stream << loadedCSVLS[0].frequenciesLs[i] << "," << averageValues[i] << ",0";
+                stream << frequencies[i] << "," << averageValues[i] << ",0";
                 stream << "\n";
             }
         }
         else if (useRsData)
         {
-            for (int i = 0; i < loadedCSVRS[0].frequenciesRs.size(); ++i)
+            for (int i = 0; i < count; ++i)
             {
-                stream << loadedCSVRS[0].frequenciesRs[i] << ",0," << averageValues[i];	// Set LS column to zeros
+                stream << frequencies[i] << ",0," << averageValues[i];	// Set LS column to zeros
                 stream << "\n";
             }
         }
@@ -240,24 +825,12 @@ void MainWindow::on_btn_export_avg_clicked()
             QTextStream readmeStream(&readmeFile);
             readmeStream << "Average Graph Data\n";
             readmeStream << "Using the following Core for calculation:\n";
-            if (useLsData)
-            {
-                for (int i = 0; i < loadedCSVLS.size(); ++i)
-                {
-                    if (loadedCSVLS[i].visible)
-                    {
-                        readmeStream << "CORE:  " << (loadedCSVLS[i].fileName) << "\n";
-                    }
-                }
-            }
-            else
+            const ChannelMatrix &matrix = dataset.channel(useLsData);
+            for (int i = 0; i < matrix.coreCount(); ++i)
             {
-                for (int i = 0; i < loadedCSVRS.size(); ++i)
+                if (matrix.isVisible(i))
                 {
-                    if (loadedCSVRS[i].visible)
-                    {
-                        readmeStream << "CORE: " << (loadedCSVRS[i].fileName) << "\n";
-                    }
+                    readmeStream << (useLsData ? "CORE:  " : "CORE: ") << dataset.name(i) << "\n";
                 }
             }
 
@@ -0,0 +1,225 @@
+/**
+ *@file csvcache.cpp
+ *@brief Implementation of the binary cache for imported CSV files
+ *
+ *This file contains the implementation of the sidecar cache that keeps a binary copy of every
+ *parsed CSV file under the application's data location. A cache entry stores the parsed
+ *frequency, Ls and Rs columns, their channel summaries and content hash together with the source
+ *path, size, modification time and the frequency windows used while parsing. When the same file
+ *is loaded again and none of these changed, the entry is memory-mapped and copied into the
+ *columns without any text parsing. An entry that fails validation is deleted, a hit refreshes its
+ *modification time, and the least recently used entries are pruned once the cache outgrows its cap.
+ *
+ *@note Entries can be deleted at any time, the next import of their file writes them again.
+ *
+ *@date[10/16/26]
+ */
+#include "csvcache.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QElapsedTimer>
+#include <QCryptographicHash>
+#include <cstring>
+
+namespace
+{
+    const char cacheMagic[4] = { 'W', 'H', 'L', 'C' };
+    const quint32 cacheVersion = 3;
+
+    // Fixed-size header, followed by the source path (padded to 8 bytes) and the three columns
+    struct CacheHeader
+    {
+        char magic[4];
+        quint32 version;
+        qint64 sourceSize;
+        qint64 sourceModified;
+        double ranges[4];
+        qint32 rowCount;
+        qint32 lsBegin;
+        qint32 lsEnd;
+        qint32 rsBegin;
+        qint32 rsEnd;
+        quint32 pathLength;
+        ChannelSummary lsSummary;
+        ChannelSummary rsSummary;
+        quint64 contentHash;
+    };
+
+    inline qint64 paddedPathLength(qint64 length)
+    {
+        return (length + 7) & ~qint64(7);
+    }
+}
+
+CsvCache::CsvCache(const QString &directory, const CsvParser &parser):
+    directory(directory)
+{
+    ranges[0] = parser.minFrequencyLS;
+    ranges[1] = parser.maxFrequencyLS;
+    ranges[2] = parser.minFrequencyRS;
+    ranges[3] = parser.maxFrequencyRS;
+}
+
+// One cache file per source path
+QString CsvCache::cacheFilePath(const QString &absolutePath) const
+{
+    QByteArray key = QCryptographicHash::hash(absolutePath.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return directory + "/" + QString::fromLatin1(key) + ".bin";
+}
+
+// Fill result from the cache, false if there is no valid entry
+bool CsvCache::load(const QString &filePath, CsvParseResult &result) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QFileInfo source(filePath);
+    QString absolutePath = source.absoluteFilePath();
+    QByteArray pathBytes = absolutePath.toUtf8();
+
+    QFile cacheFile(cacheFilePath(absolutePath));
+    if (!cacheFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    if (cacheFile.size() < qint64(sizeof(CacheHeader)))
+    {
+        cacheFile.remove();
+        return false;
+    }
+
+    qint64 cacheSize = cacheFile.size();
+    uchar *mapped = cacheFile.map(0, cacheSize);
+    if (!mapped)
+    {
+        return false;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, mapped, sizeof(header));
+
+    // The entry is stale as soon as the source or the frequency windows changed
+    qint64 dataOffset = sizeof(CacheHeader) + paddedPathLength(header.pathLength);
+    bool valid = std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) == 0 &&
+                 header.version == cacheVersion &&
+                 header.sourceSize == source.size() &&
+                 header.sourceModified == source.lastModified().toMSecsSinceEpoch() &&
+                 std::memcmp(header.ranges, ranges, sizeof(ranges)) == 0 &&
+                 header.rowCount >= 0 &&
+                 header.pathLength == quint32(pathBytes.size()) &&
+                 dataOffset + 3 * qint64(header.rowCount) * qint64(sizeof(double)) == cacheSize &&
+                 std::memcmp(mapped + sizeof(CacheHeader), pathBytes.constData(), pathBytes.size()) == 0 &&
+                 header.lsBegin >= 0 && header.lsBegin <= header.lsEnd && header.lsEnd <= header.rowCount &&
+                 header.rsBegin >= 0 && header.rsBegin <= header.rsEnd && header.rsEnd <= header.rowCount;
+
+    if (valid)
+    {
+        const double *column = reinterpret_cast<const double*> (mapped + dataOffset);
+        int rows = header.rowCount;
+
+        result = CsvParseResult();
+        result.filePath = filePath;
+        result.columns.frequencies = QVector<double> (column, column + rows);
+        result.columns.lsValues = QVector<double> (column + rows, column + 2 * rows);
+        result.columns.rsValues = QVector<double> (column + 2 * rows, column + 3 * rows);
+        result.lsWindow.begin = header.lsBegin;
+        result.lsWindow.end = header.lsEnd;
+        result.rsWindow.begin = header.rsBegin;
+        result.rsWindow.end = header.rsEnd;
+        result.lsSummary = header.lsSummary;
+        result.rsSummary = header.rsSummary;
+        result.contentHash = header.contentHash;
+        result.fromCache = true;
+        result.bytes = header.sourceSize;
+    }
+
+    cacheFile.unmap(mapped);
+
+    if (valid)
+    {
+        // Hits keep an entry young for prune
+        cacheFile.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+    else
+    {
+        // Stale or damaged, store writes a new one after the file is parsed
+        cacheFile.remove();
+    }
+
+    result.elapsedNs = timer.nsecsElapsed();
+    return valid;
+}
+
+// Write the parsed columns of result next to the other cache entries
+bool CsvCache::store(const CsvParseResult &result) const
+{
+    // Files with quarantined rows are parsed again so their report is shown again
+    if (result.status != CsvParseResult::Ok || !result.diagnostics.isEmpty())
+    {
+        return false;
+    }
+
+    QFileInfo source(result.filePath);
+    QByteArray pathBytes = source.absoluteFilePath().toUtf8();
+
+    CacheHeader header;
+    std::memset(static_cast<void*> (&header), 0, sizeof(header));	// Zeroed padding keeps the files reproducible
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.sourceSize = source.size();
+    header.sourceModified = source.lastModified().toMSecsSinceEpoch();
+    std::memcpy(header.ranges, ranges, sizeof(ranges));
+    header.rowCount = result.rowCount();
+    header.lsBegin = result.lsWindow.begin;
+    header.lsEnd = result.lsWindow.end;
+    header.rsBegin = result.rsWindow.begin;
+    header.rsEnd = result.rsWindow.end;
+    header.pathLength = pathBytes.size();
+    header.lsSummary = result.lsSummary;
+    header.rsSummary = result.rsSummary;
+    header.contentHash = result.contentHash;
+
+    // Write to a temporary file first so a crash never leaves a half-written entry
+    QSaveFile cacheFile(cacheFilePath(source.absoluteFilePath()));
+    if (!cacheFile.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    pathBytes.append(QByteArray(paddedPathLength(pathBytes.size()) - pathBytes.size(), '\0'));
+    qint64 columnBytes = qint64(header.rowCount) * qint64(sizeof(double));
+
+    cacheFile.write(reinterpret_cast<const char*> (&header), sizeof(header));
+    cacheFile.write(pathBytes);
+    // A streamed file is written from its mapped columns, page by page
+    cacheFile.write(reinterpret_cast<const char*> (result.frequencies().data), columnBytes);
+    cacheFile.write(reinterpret_cast<const char*> (result.lsValues().data), columnBytes);
+    cacheFile.write(reinterpret_cast<const char*> (result.rsValues().data), columnBytes);
+
+    return cacheFile.commit();
+}
+
+// Oldest entries go first, an entry's modification time is its last store or hit
+void CsvCache::prune(qint64 maxBytes) const
+{
+    QFileInfoList entries = QDir(directory).entryInfoList(QStringList() << "*.bin", QDir::Files, QDir::Time);
+
+    qint64 totalBytes = 0;
+    for (const QFileInfo &entry: entries)
+    {
+        totalBytes += entry.size();
+    }
+
+    while (totalBytes > maxBytes && !entries.isEmpty())
+    {
+        QFileInfo oldest = entries.takeLast();
+        if (QFile::remove(oldest.absoluteFilePath()))
+        {
+            totalBytes -= oldest.size();
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef CSVCACHE_H
+#define CSVCACHE_H
+
+#include "csvparser.h"
+#include <QString>
+
+// Binary copies of parsed CSV files, keyed by source path, size and modification time
+class CsvCache
+{
+public:
+    CsvCache(const QString &directory, const CsvParser &parser);
+
+    bool load(const QString &filePath, CsvParseResult &result) const;
+    bool store(const CsvParseResult &result) const;
+
+    // Remove the least recently used entries until the cache holds at most maxBytes
+    void prune(qint64 maxBytes) const;
+
+private:
+    QString cacheFilePath(const QString &absolutePath) const;
+
+    QString directory;
+    double ranges[4];	// Frequency windows the cached columns were filtered with
+};
+
+#endif // CSVCACHE_H
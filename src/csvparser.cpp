@@ -0,0 +1,960 @@
+/**
+ *@file csvparser.cpp
+ *@brief Implementation of the memory-mapped CSV ingest engine
+ *
+ *This file contains the implementation of the CSV parser used by the Load CSV path. The file
+ *is memory-mapped and every FREQUENCY,Ls,Rs row is converted directly from the raw bytes, so
+ *no QString or QStringList is created per row. Line and field boundaries come from a structural
+ *index that CsvScanner builds for a whole block at once with SIMD instructions. Each field is
+ *converted once into a single frequency column plus the Ls and Rs columns; the LS and RS
+ *frequency ranges are kept as row windows into these shared columns, and the min, max, sum,
+ *sum of squares and frequency span of both channels are summarized on the way. The header row is matched
+ *against a column schema, so wider instrument exports (Cs, Q, D, |Z|, phase, ...) load as well:
+ *only the FREQUENCY, Ls and Rs fields are converted, every other field is skipped. Ls and Rs are
+ *only converted for rows inside one of the windows, and an ascending sweep stops being read once
+ *it has passed both. The delimiter (',', ';' or tab), a decimal comma and a UTF-8 or UTF-16 byte
+ *order mark are detected from the first lines, so exports of Turkish-locale stations load
+ *without a conversion step. Very large files can instead be streamed in fixed-size chunks,
+ *handing out the rows of each chunk as soon as it is parsed and appending them to file-backed
+ *columns, so the rows of a streamed file are never all held on the heap. Gzip-compressed .csv.gz files
+ *always take the chunked path, fed by a device that inflates on its own thread. The time spent
+ *on every file is recorded for throughput reports.
+ *
+ *@note The parser keeps no state between files, the loader copies one instance into every worker.
+ *
+ *@date[10/16/26]
+ */
+#include "csvparser.h"
+#include "gzipdevice.h"
+#include "csvscanner.h"
+#include <QFile>
+#include <QScopedPointer>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QStringList>
+#include <QStringDecoder>
+#include <cstring>
+#include <algorithm>
+#include <numeric>
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+namespace
+{
+    // Reported rows per file, the rest is only counted
+    const int maxDiagnosticsPerFile = 50;
+
+    // Bytes indexed by the scanner at once, small enough to stay in the L2 cache
+    const qint64 scanBlockBytes = 64 * 1024;
+
+    // Inflated text parsed at once from a .csv.gz file
+    const qint64 gzipChunkBytes = 1024 * 1024;
+
+    inline bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    // Find the field starting at cursor and move the cursor to the next one, nullptr after the last field
+    inline const char *nextField(const char *&cursor, const char *lineEnd, char delimiter, const char *&fieldEnd)
+    {
+        const char *begin = cursor;
+        fieldEnd = static_cast<const char*> (std::memchr(begin, delimiter, lineEnd - begin));
+        if (fieldEnd)
+        {
+            cursor = fieldEnd + 1;
+        }
+        else
+        {
+            fieldEnd = lineEnd;
+            cursor = nullptr;
+        }
+
+        return begin;
+    }
+
+    inline bool toDouble(const char *begin, const char *end, double &value)
+    {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        std::from_chars_result converted = std::from_chars(begin, end, value);
+        return converted.ec == std::errc() && converted.ptr == end;
+#else
+        bool ok = false;
+        value = QByteArray::fromRawData(begin, int(end - begin)).toDouble(&ok);
+        return ok;
+#endif
+    }
+
+    // Convert the field [begin, end), a missing field (nullptr) is invalid
+    inline bool convertField(const char *begin, const char *end, bool decimalComma, double &value)
+    {
+        if (!begin)
+        {
+            return false;
+        }
+
+        // Same tolerance as QString::toDouble: surrounding blanks and a leading '+'
+        while (begin < end && isBlank(*begin))
+        {
+            ++begin;
+        }
+
+        while (end > begin && isBlank(end[-1]))
+        {
+            --end;
+        }
+
+        if (begin < end && *begin == '+')
+        {
+            ++begin;
+        }
+
+        if (begin == end)
+        {
+            return false;
+        }
+
+        if (decimalComma)
+        {
+            // "1,5E-06" is converted from a short local copy as "1.5E-06"
+            char text[64];
+            if (end - begin >= qint64(sizeof(text)))
+            {
+                return false;
+            }
+
+            char *out = text;
+            for (const char *c = begin; c < end; ++c)
+            {
+                *out++ = *c == ',' ? '.' : *c;
+            }
+
+            return toDouble(text, out, value);
+        }
+
+        return toDouble(begin, end, value);
+    }
+
+    // splitmix64 finalizer, a fast non-cryptographic 64-bit mix
+    inline quint64 mixHash(quint64 value)
+    {
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ULL;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebULL;
+        value ^= value >> 31;
+        return value;
+    }
+
+    inline quint64 doubleBits(double value)
+    {
+        value += 0.0;	// -0.0 and 0.0 hash alike
+        quint64 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline quint64 rowHash(double frequency, double lsValue, double rsValue)
+    {
+        quint64 hash = mixHash(doubleBits(frequency) + 0x9e3779b97f4a7c15ULL);
+        hash = mixHash(hash ^ doubleBits(lsValue));
+        return mixHash(hash ^ doubleBits(rsValue));
+    }
+
+    // Byte order mark of a UTF-16 export, the only encoding that has to be transcoded
+    inline bool isUtf16(const char *data, qint64 size)
+    {
+        return size >= 2 && ((uchar(data[0]) == 0xFF && uchar(data[1]) == 0xFE) ||
+                             (uchar(data[0]) == 0xFE && uchar(data[1]) == 0xFF));
+    }
+
+    QByteArray utf16ToUtf8(const char *data, qint64 size)
+    {
+        bool bigEndian = uchar(data[0]) == 0xFE;
+        QStringDecoder decoder(bigEndian ? QStringConverter::Utf16BE : QStringConverter::Utf16LE);
+        QString text = decoder.decode(QByteArrayView(data + 2, size - 2));
+        return text.toUtf8();
+    }
+
+    // Header cell without blanks, quotes and unit suffix, in lower case: "Ls (H)" -> "ls"
+    QByteArray headerName(const char *begin, const char *end)
+    {
+        const char *unit = begin;
+        while (unit < end && *unit != '(' && *unit != '[')
+        {
+            ++unit;
+        }
+
+        end = unit;
+        while (begin < end && (isBlank(*begin) || *begin == '"'))
+        {
+            ++begin;
+        }
+
+        while (end > begin && (isBlank(end[-1]) || end[-1] == '"'))
+        {
+            --end;
+        }
+
+        return QByteArray(begin, int(end - begin)).toLower();
+    }
+
+    // Rows of a sweep written out of order, keeps equal frequencies in file order
+    void sortByFrequency(CoreColumns &columns)
+    {
+        const QVector<double> &frequencies = columns.frequencies;
+
+        QVector<int> order(frequencies.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&frequencies](int a, int b)
+                         {
+                             return frequencies[a] < frequencies[b];
+                         });
+
+        CoreColumns sortedColumns;
+        sortedColumns.frequencies.reserve(order.size());
+        sortedColumns.lsValues.reserve(order.size());
+        sortedColumns.rsValues.reserve(order.size());
+        for (int row: order)
+        {
+            sortedColumns.frequencies.append(columns.frequencies[row]);
+            sortedColumns.lsValues.append(columns.lsValues[row]);
+            sortedColumns.rsValues.append(columns.rsValues[row]);
+        }
+
+        columns = sortedColumns;
+    }
+
+    // Same for the rows of a streamed file. Each column is permuted in place by following the
+    // cycles of the order, so only the order and a flag per row are held besides the mapped columns.
+    void sortByFrequency(StreamedColumns &columns)
+    {
+        const double *frequencies = columns.frequencies.constData();
+
+        QVector<int> order(int(columns.frequencies.size()));
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [frequencies](int a, int b)
+                         {
+                             return frequencies[a] < frequencies[b];
+                         });
+
+        QVector<bool> placed(order.size());
+        for (MatrixStore *store: {&columns.frequencies, &columns.lsValues, &columns.rsValues})
+        {
+            double *column = store->data();
+            placed.fill(false);
+            for (int start = 0; start < order.size(); ++start)
+            {
+                if (placed[start])
+                {
+                    continue;
+                }
+
+                // Row i takes the value of row order[i] until the cycle is back at start
+                double first = column[start];
+                int row = start;
+                while (order[row] != start)
+                {
+                    column[row] = column[order[row]];
+                    placed[row] = true;
+                    row = order[row];
+                }
+
+                column[row] = first;
+                placed[row] = true;
+            }
+        }
+    }
+
+    // Rows whose frequency lies in [minFrequency, maxFrequency]
+    FrequencyWindow windowOf(const ColumnSpan &frequencies, double minFrequency, double maxFrequency)
+    {
+        FrequencyWindow window;
+        window.begin = int(std::lower_bound(frequencies.begin(), frequencies.end(), minFrequency) - frequencies.begin());
+        window.end = int(std::upper_bound(frequencies.begin(), frequencies.end(), maxFrequency) - frequencies.begin());
+        window.end = qMax(window.begin, window.end);
+        return window;
+    }
+}
+
+// Combine the statistics of two parts of a channel
+void ChannelSummary::merge(const ChannelSummary &other)
+{
+    if (other.count == 0)
+    {
+        return;
+    }
+
+    if (count == 0)
+    {
+        *this = other;
+        return;
+    }
+
+    minValue = qMin(minValue, other.minValue);
+    maxValue = qMax(maxValue, other.maxValue);
+    firstFrequency = qMin(firstFrequency, other.firstFrequency);
+    lastFrequency = qMax(lastFrequency, other.lastFrequency);
+    count += other.count;
+    sum += other.sum;
+    sumOfSquares += other.sumOfSquares;
+}
+
+double ChannelSummary::variance() const
+{
+    if (count == 0)
+    {
+        return 0.0;
+    }
+
+    double average = mean();
+    return qMax(0.0, sumOfSquares / count - average * average);
+}
+
+double CsvParseResult::throughputMBps() const
+{
+    if (elapsedNs <= 0)
+    {
+        return 0.0;
+    }
+
+    return (bytes / 1e6) / (elapsedNs / 1e9);
+}
+
+int CsvParseResult::rowCount() const
+{
+    return streamedColumns ? int(streamedColumns->frequencies.size()) : columns.frequencies.size();
+}
+
+ColumnSpan CsvParseResult::frequencies() const
+{
+    return streamedColumns ? ColumnSpan(streamedColumns->frequencies.constData(), rowCount()) : ColumnSpan(columns.frequencies);
+}
+
+ColumnSpan CsvParseResult::lsValues() const
+{
+    return streamedColumns ? ColumnSpan(streamedColumns->lsValues.constData(), rowCount()) : ColumnSpan(columns.lsValues);
+}
+
+ColumnSpan CsvParseResult::rsValues() const
+{
+    return streamedColumns ? ColumnSpan(streamedColumns->rsValues.constData(), rowCount()) : ColumnSpan(columns.rsValues);
+}
+
+CsvParser::CsvParser(double minFrequencyLS, double maxFrequencyLS, double minFrequencyRS, double maxFrequencyRS):
+    minFrequencyLS(minFrequencyLS),
+    maxFrequencyLS(maxFrequencyLS),
+    minFrequencyRS(minFrequencyRS),
+    maxFrequencyRS(maxFrequencyRS)
+{
+}
+
+CsvSchema::CsvSchema()
+{
+    names[Frequency] << "FREQUENCY" << "FREQ" << "F";
+    names[Ls] << "Ls";
+    names[Rs] << "Rs";
+}
+
+void CsvParser::setSchema(const CsvSchema &schema)
+{
+    this->schema = schema;
+}
+
+// Map the file and parse it in place, compressed files are inflated while they are parsed
+CsvParseResult CsvParser::parseFile(const QString &filePath) const
+{
+    if (isCompressed(filePath))
+    {
+        CsvParseResult result = parseStream(filePath, gzipChunkBytes, ChunkHandler());
+        result.streamed = false;
+        return result;
+    }
+
+    CsvParseResult result;
+    result.filePath = filePath;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        result.status = CsvParseResult::OpenFailed;
+        return result;
+    }
+
+    result.bytes = file.size();
+    if (result.bytes > 0)
+    {
+        uchar *mapped = file.map(0, result.bytes);
+        if (mapped)
+        {
+            parseBuffer(reinterpret_cast<const char*> (mapped), result.bytes, result);
+            file.unmap(mapped);
+        }
+        else
+        {
+            // Some devices cannot be mapped, fall back to a single read
+            QByteArray content = file.readAll();
+            parseBuffer(content.constData(), content.size(), result);
+        }
+    }
+
+    file.close();
+
+    result.elapsedNs = timer.nsecsElapsed();
+    return result;
+}
+
+// .csv.gz sweeps
+bool CsvParser::isCompressed(const QString &filePath)
+{
+    return filePath.endsWith(".gz", Qt::CaseInsensitive);
+}
+
+// A file that already is in memory, such as a member of a tar bundle
+CsvParseResult CsvParser::parseMemory(const QString &filePath, const char *data, qint64 size) const
+{
+    CsvParseResult result;
+    result.filePath = filePath;
+    result.bytes = size;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (size > 0)
+    {
+        parseBuffer(data, size, result);
+    }
+
+    result.elapsedNs = timer.nsecsElapsed();
+    return result;
+}
+
+// Parse FREQUENCY,Ls,Rs rows from a raw buffer
+void CsvParser::parseBuffer(const char *data, qint64 size, CsvParseResult &result) const
+{
+    // Every ASCII-compatible encoding is parsed in place, UTF-16 is transcoded first
+    if (isUtf16(data, size))
+    {
+        QByteArray text = utf16ToUtf8(data, size);
+        parseBuffer(text.constData(), text.size(), result);
+        return;
+    }
+
+    const char *cursor = data;
+    const char *end = data + size;
+
+    LineState state;
+    cursor = readHeader(cursor, end, state, result);
+    if (!cursor)
+    {
+        return;
+    }
+
+    // Rough row estimate from the first data row so the columns grow only a few times
+    const char *sampleEnd = static_cast<const char*> (std::memchr(cursor, '\n', end - cursor));
+    qint64 estimatedRows = sampleEnd ? (end - cursor) / (sampleEnd - cursor + 1) + 1 : 1;
+
+    CoreColumns &columns = result.columns;
+    columns.frequencies.reserve(estimatedRows);
+    columns.lsValues.reserve(estimatedRows);
+    columns.rsValues.reserve(estimatedRows);
+
+    parseLines(cursor, end, state, columns, result);
+    finishColumns(state, result);
+}
+
+// Read the file in fixed-size chunks and hand every chunk's rows to handler
+CsvParseResult CsvParser::parseStream(const QString &filePath, qint64 chunkBytes, const ChunkHandler &handler) const
+{
+    CsvParseResult result;
+    result.filePath = filePath;
+    result.streamed = true;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // A compressed file is inflated on the device's own thread while this one parses
+    QScopedPointer<QIODevice> device;
+    if (isCompressed(filePath))
+    {
+        device.reset(new GzipDevice(filePath));
+    }
+    else
+    {
+        device.reset(new QFile(filePath));
+    }
+
+    if (!device->open(QIODevice::ReadOnly))
+    {
+        result.status = CsvParseResult::OpenFailed;
+        return result;
+    }
+
+    parseDevice(*device, chunkBytes, handler, result);
+    device->close();
+
+    result.elapsedNs = timer.nsecsElapsed();
+    return result;
+}
+
+// Parse the chunks read from device, bytes counts the (inflated) text
+void CsvParser::parseDevice(QIODevice &device, qint64 chunkBytes, const ChunkHandler &handler, CsvParseResult &result) const
+{
+    QByteArray buffer(int(chunkBytes), Qt::Uninitialized);
+    qint64 filled = 0;
+    bool atEnd = false;
+    bool headerRead = false;
+
+    LineState state;
+    CoreColumns chunk;
+
+    while (!atEnd)
+    {
+        qint64 read = device.read(buffer.data() + filled, buffer.size() - filled);
+        if (read < 0)
+        {
+            // Unreadable or corrupt input: the rows read so far cannot be trusted
+            CsvDiagnostic diagnostic;
+            diagnostic.filePath = result.filePath;
+            diagnostic.reason = device.errorString();
+            result.diagnostics.append(diagnostic);
+            result.status = CsvParseResult::InvalidFormat;
+            return;
+        }
+
+        if (read == 0)
+        {
+            atEnd = true;
+        }
+        else
+        {
+            filled += read;
+            result.bytes += read;
+        }
+
+        const char *begin = buffer.constData();
+        const char *stop = begin + filled;
+
+        if (!headerRead && isUtf16(begin, filled))
+        {
+            // UTF-16 cannot be split into lines as raw bytes, transcode the whole file at once
+            QByteArray content = buffer.left(int(filled)) + device.readAll();
+            result.bytes = content.size();
+            parseBuffer(content.constData(), content.size(), result);
+
+            if (handler && result.status == CsvParseResult::Ok && !result.columns.frequencies.isEmpty() && !handler(result.columns))
+            {
+                result.status = CsvParseResult::Cancelled;
+            }
+
+            return;
+        }
+
+        // Only complete lines are parsed, the tail waits for the next chunk
+        const char *complete = stop;
+        if (!atEnd)
+        {
+            while (complete > begin && complete[-1] != '\n')
+            {
+                --complete;
+            }
+
+            if (complete == begin)
+            {
+                // A single line longer than the buffer
+                if (filled == buffer.size())
+                {
+                    buffer.resize(buffer.size() * 2);
+                }
+
+                continue;
+            }
+        }
+
+        const char *cursor = begin;
+        if (!headerRead)
+        {
+            cursor = readHeader(cursor, complete, state, result);
+            if (!cursor)
+            {
+                return;
+            }
+
+            headerRead = true;
+        }
+
+        chunk.frequencies.clear();
+        chunk.lsValues.clear();
+        chunk.rsValues.clear();
+
+        parseLines(cursor, complete, state, chunk, result);
+
+        if (!chunk.frequencies.isEmpty() && handler)
+        {
+            // Handed-out chunks go to the file-backed columns, the chunk itself lives on only in the handler
+            if (!result.streamedColumns)
+            {
+                result.streamedColumns = QSharedPointer<StreamedColumns>::create();
+            }
+
+            StreamedColumns &streamed = *result.streamedColumns;
+            if (!streamed.frequencies.append(chunk.frequencies.constData(), chunk.frequencies.size()) ||
+                !streamed.lsValues.append(chunk.lsValues.constData(), chunk.lsValues.size()) ||
+                !streamed.rsValues.append(chunk.rsValues.constData(), chunk.rsValues.size()))
+            {
+                CsvDiagnostic diagnostic;
+                diagnostic.filePath = result.filePath;
+                diagnostic.reason = "The rows could not be written to the temporary folder";
+                result.diagnostics.append(diagnostic);
+                result.status = CsvParseResult::InvalidFormat;
+                result.streamedColumns.reset();
+                return;
+            }
+
+            if (!handler(chunk))
+            {
+                result.status = CsvParseResult::Cancelled;
+                break;
+            }
+        }
+        else if (!chunk.frequencies.isEmpty())
+        {
+            result.columns.frequencies.append(chunk.frequencies);
+            result.columns.lsValues.append(chunk.lsValues);
+            result.columns.rsValues.append(chunk.rsValues);
+        }
+
+        if (state.finished)
+        {
+            break;
+        }
+
+        // Keep the incomplete tail for the next read
+        filled = stop - complete;
+        std::memmove(buffer.data(), complete, filled);
+    }
+
+    if (result.status == CsvParseResult::Cancelled)
+    {
+        result.streamedColumns.reset();
+        return;
+    }
+
+    finishColumns(state, result);
+}
+
+// Map the needed columns from the header row, returns the start of the data or nullptr if a column is missing
+const char *CsvParser::readHeader(const char *cursor, const char *end, LineState &state, CsvParseResult &result) const
+{
+    // UTF-8 byte order mark
+    if (end - cursor >= 3 && uchar(cursor[0]) == 0xEF && uchar(cursor[1]) == 0xBB && uchar(cursor[2]) == 0xBF)
+    {
+        cursor += 3;
+    }
+
+    const char *headerEnd = static_cast<const char*> (std::memchr(cursor, '\n', end - cursor));
+    const char *lineEnd = headerEnd ? headerEnd : end;
+
+    // Delimiter: ';' or tab when the header uses them at least as often as ','
+    int commas = int(std::count(cursor, lineEnd, ','));
+    int semicolons = int(std::count(cursor, lineEnd, ';'));
+    int tabs = int(std::count(cursor, lineEnd, '\t'));
+    if (semicolons > 0 && semicolons >= commas && semicolons >= tabs)
+    {
+        state.delimiter = ';';
+    }
+    else if (tabs > 0 && tabs >= commas)
+    {
+        state.delimiter = '\t';
+    }
+
+    // Decimal comma: a ',' inside the first data row of a file that is not comma-separated
+    if (state.delimiter != ',' && headerEnd)
+    {
+        const char *sampleEnd = static_cast<const char*> (std::memchr(headerEnd + 1, '\n', end - headerEnd - 1));
+        state.decimalComma = std::find(headerEnd + 1, sampleEnd ? sampleEnd : end, ',') != (sampleEnd ? sampleEnd : end);
+    }
+
+    QVector<QByteArray> cells;
+    const char *field = cursor;
+    while (field)
+    {
+        const char *fieldEnd;
+        const char *begin = nextField(field, lineEnd, state.delimiter, fieldEnd);
+        cells.append(headerName(begin, fieldEnd));
+    }
+
+    int found = 0;
+    int fieldIndex[CsvSchema::ColumnCount];
+    for (int column = 0; column < CsvSchema::ColumnCount; ++column)
+    {
+        fieldIndex[column] = -1;
+        for (const QString &name: schema.names[column])
+        {
+            int index = cells.indexOf(name.toLower().toLatin1());
+            if (index >= 0)
+            {
+                fieldIndex[column] = index;
+                ++found;
+                break;
+            }
+        }
+    }
+
+    // Files without recognizable names keep the classic FREQUENCY,Ls,Rs order
+    if (found == CsvSchema::ColumnCount)
+    {
+        std::copy(fieldIndex, fieldIndex + CsvSchema::ColumnCount, state.fieldIndex);
+    }
+    else if (found > 0)
+    {
+        const char *columnNames[CsvSchema::ColumnCount] = { "FREQUENCY", "Ls", "Rs" };
+        for (int column = 0; column < CsvSchema::ColumnCount; ++column)
+        {
+            if (fieldIndex[column] < 0)
+            {
+                CsvDiagnostic diagnostic;
+                diagnostic.filePath = result.filePath;
+                diagnostic.line = 1;
+                diagnostic.reason = QString("No %1 column in the header, file skipped").arg(columnNames[column]);
+                result.diagnostics.append(diagnostic);
+            }
+        }
+
+        result.status = CsvParseResult::InvalidFormat;
+        return nullptr;
+    }
+
+    return headerEnd ? headerEnd + 1 : end;
+}
+
+// Parse the complete lines in [cursor, end) and append the rows inside the windows to columns
+void CsvParser::parseLines(const char *cursor, const char *end, LineState &state, CoreColumns &columns, CsvParseResult &result) const
+{
+    const double upperFrequency = qMax(maxFrequencyLS, maxFrequencyRS);
+
+    // Structural index of one block: the offsets of its delimiters and line ends
+    CsvScanner scanner(state.delimiter);
+    QVector<quint32> positions(int(qMin<qint64>(end - cursor, scanBlockBytes)));
+
+    while (cursor < end)
+    {
+        // Index a block in one pass, then cut it after its last complete line
+        const char *block = cursor;
+        const char *blockEnd = block + qMin<qint64>(end - block, scanBlockBytes);
+        int count = scanner.scan(block, int(blockEnd - block), positions.data());
+        if (blockEnd < end)
+        {
+            int last = count - 1;
+            while (last >= 0 && block[positions[last]] != '\n')
+            {
+                --last;
+            }
+
+            if (last >= 0)
+            {
+                blockEnd = block + positions[last] + 1;
+                count = last + 1;
+            }
+            else
+            {
+                // A single line longer than the block
+                const char *lineEnd = static_cast<const char*> (std::memchr(blockEnd, '\n', end - blockEnd));
+                blockEnd = lineEnd ? lineEnd + 1 : end;
+                positions.resize(int(blockEnd - block));
+                count = scanner.scan(block, int(blockEnd - block), positions.data());
+            }
+        }
+
+        const quint32 *position = positions.constData();
+        const quint32 *positionsEnd = position + count;
+        cursor = blockEnd;
+
+        const char *lineStart = block;
+        while (lineStart < blockEnd)
+        {
+            ++state.lineNumber;
+
+            // Delimiters of this line, up to its '\n'
+            const quint32 *delimiters = position;
+            while (position < positionsEnd && block[*position] != '\n')
+            {
+                ++position;
+            }
+
+            int delimiterCount = int(position - delimiters);
+            const char *lineEnd = blockEnd;
+            if (position < positionsEnd)
+            {
+                lineEnd = block + *position;
+                ++position;
+            }
+
+            const char *field = lineStart;
+            lineStart = lineEnd + 1;
+
+            // Blank lines (e.g. a trailing "\r\n") carry no data
+            const char *firstChar = field;
+            while (firstChar < lineEnd && isBlank(*firstChar))
+            {
+                ++firstChar;
+            }
+
+            if (firstChar == lineEnd)
+            {
+                continue;
+            }
+
+            // Locate the projected fields through the index, the other columns are never looked at
+            const char *fieldBegin[CsvSchema::ColumnCount] = {};
+            const char *fieldEnd[CsvSchema::ColumnCount] = {};
+            for (int column = 0; column < CsvSchema::ColumnCount; ++column)
+            {
+                int index = state.fieldIndex[column];
+                if (index <= delimiterCount)
+                {
+                    fieldBegin[column] = index == 0 ? field : block + delimiters[index - 1] + 1;
+                    fieldEnd[column] = index < delimiterCount ? block + delimiters[index] : lineEnd;
+                }
+            }
+
+            // Read the FREQUENCY first, Ls and Rs are only converted for rows inside a window.
+            // A bad row is quarantined and parsing goes on.
+            double frequency, lsValue, rsValue;
+            bool inLs = false;
+            bool inRs = false;
+            const char *reason = nullptr;
+            if (!convertField(fieldBegin[CsvSchema::Frequency], fieldEnd[CsvSchema::Frequency], state.decimalComma, frequency))
+            {
+                reason = "Invalid FREQUENCY value";
+            }
+            else
+            {
+                inLs = frequency >= minFrequencyLS && frequency <= maxFrequencyLS;
+                inRs = frequency >= minFrequencyRS && frequency <= maxFrequencyRS;
+                if (inLs || inRs)
+                {
+                    if (!convertField(fieldBegin[CsvSchema::Ls], fieldEnd[CsvSchema::Ls], state.decimalComma, lsValue))
+                    {
+                        reason = "Missing or invalid Ls value";
+                    }
+                    else if (!convertField(fieldBegin[CsvSchema::Rs], fieldEnd[CsvSchema::Rs], state.decimalComma, rsValue))
+                    {
+                        reason = "Missing or invalid Rs value";
+                    }
+                }
+            }
+
+            if (reason)
+            {
+                if (result.skippedRows < maxDiagnosticsPerFile)
+                {
+                    CsvDiagnostic diagnostic;
+                    diagnostic.filePath = result.filePath;
+                    diagnostic.line = state.lineNumber;
+                    diagnostic.reason = QString::fromLatin1(reason);
+                    result.diagnostics.append(diagnostic);
+                }
+
+                ++result.skippedRows;
+                continue;
+            }
+
+            if (state.validRows > 0 && frequency < state.previousFrequency)
+            {
+                state.ascending = false;
+            }
+
+            state.previousFrequency = frequency;
+            ++state.validRows;
+
+            // Rows outside both windows are not kept
+            if (!inLs && !inRs)
+            {
+                // An ascending sweep past both windows has nothing left for us
+                if (state.ascending && state.rows > 0 && frequency > upperFrequency)
+                {
+                    state.finished = true;
+                    return;
+                }
+
+                continue;
+            }
+
+            if (state.rows > 0 && frequency < state.lastFrequency)
+            {
+                state.sorted = false;
+            }
+
+            state.lastFrequency = frequency;
+            ++state.rows;
+
+            // Summaries are gathered here so nothing has to walk the columns again
+            if (inLs)
+            {
+                result.lsSummary.add(frequency, lsValue);
+            }
+
+            if (inRs)
+            {
+                result.rsSummary.add(frequency, rsValue);
+            }
+
+            state.rowHashSum += rowHash(frequency, lsValue, rsValue);
+
+            columns.frequencies.append(frequency);
+            columns.lsValues.append(lsValue);
+            columns.rsValues.append(rsValue);
+        }
+    }
+}
+
+// Sort the parsed columns if needed and locate the LS and RS windows
+void CsvParser::finishColumns(const LineState &state, CsvParseResult &result) const
+{
+    CoreColumns &columns = result.columns;
+
+    if (result.skippedRows > maxDiagnosticsPerFile)
+    {
+        CsvDiagnostic diagnostic;
+        diagnostic.filePath = result.filePath;
+        diagnostic.reason = QString("%1 more invalid rows skipped").arg(result.skippedRows - maxDiagnosticsPerFile);
+        result.diagnostics.append(diagnostic);
+    }
+
+    result.contentHash = mixHash(state.rowHashSum ^ mixHash(quint64(state.rows)));
+
+    // Nothing usable at all: the whole file is quarantined
+    if (state.validRows == 0 && result.skippedRows > 0)
+    {
+        CsvDiagnostic diagnostic;
+        diagnostic.filePath = result.filePath;
+        diagnostic.reason = "No valid FREQUENCY,Ls,Rs rows, file skipped";
+        result.diagnostics.append(diagnostic);
+        result.status = CsvParseResult::InvalidFormat;
+        return;
+    }
+
+    if (!state.sorted && result.streamedColumns)
+    {
+        sortByFrequency(*result.streamedColumns);
+    }
+    else if (!state.sorted)
+    {
+        sortByFrequency(columns);
+    }
+    else
+    {
+        // Give back the part of the row estimate that was filtered out
+        columns.frequencies.squeeze();
+        columns.lsValues.squeeze();
+        columns.rsValues.squeeze();
+    }
+
+    result.lsWindow = windowOf(result.frequencies(), minFrequencyLS, maxFrequencyLS);
+    result.rsWindow = windowOf(result.frequencies(), minFrequencyRS, maxFrequencyRS);
+}
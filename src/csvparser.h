@@ -0,0 +1,216 @@
+#ifndef CSVPARSER_H
+#define CSVPARSER_H
+
+#include <QString>
+#include <QVector>
+#include <QStringList>
+#include <QSharedPointer>
+#include <functional>
+#include "matrixstore.h"
+
+class QIODevice;
+
+// Columns of one sweep, sorted by frequency. Every row is converted once and
+// shared by the LS and RS views of the core.
+struct CoreColumns
+{
+    QVector<double> frequencies;
+    QVector<double> lsValues;
+    QVector<double> rsValues;
+};
+
+// Row range [begin, end) of a frequency window inside CoreColumns
+struct FrequencyWindow
+{
+    int begin = 0;
+    int end = 0;
+
+    int size() const { return end - begin; }
+};
+
+// Read-only slice of a column
+struct ColumnSpan
+{
+    const double *data = nullptr;
+    int count = 0;
+
+    ColumnSpan() {}
+    ColumnSpan(const double *data, int count): data(data), count(count) {}
+    ColumnSpan(const QVector<double> &column): data(column.constData()), count(column.size()) {}
+    ColumnSpan(const ColumnSpan &column, const FrequencyWindow &window):
+        data(column.data + window.begin), count(window.size()) {}
+
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    double operator[](int i) const { return data[i]; }
+    const double *begin() const { return data; }
+    const double *end() const { return data + count; }
+};
+
+// Statistics of one channel of a core, gathered while its rows are parsed
+struct ChannelSummary
+{
+    int count = 0;
+    double minValue = 0.0;
+    double maxValue = 0.0;
+    double sum = 0.0;
+    double sumOfSquares = 0.0;
+    double firstFrequency = 0.0;	// Frequency span of the sweep
+    double lastFrequency = 0.0;
+
+    void add(double frequency, double value)
+    {
+        if (count == 0)
+        {
+            minValue = maxValue = value;
+            firstFrequency = lastFrequency = frequency;
+        }
+        else
+        {
+            minValue = qMin(minValue, value);
+            maxValue = qMax(maxValue, value);
+            firstFrequency = qMin(firstFrequency, frequency);
+            lastFrequency = qMax(lastFrequency, frequency);
+        }
+
+        ++count;
+        sum += value;
+        sumOfSquares += value * value;
+    }
+
+    void merge(const ChannelSummary &other);
+    double mean() const { return count > 0 ? sum / count : 0.0; }
+    double variance() const;
+};
+
+// A row or file that was left out of an import
+struct CsvDiagnostic
+{
+    QString filePath;
+    int line = 0;	// 0 when the whole file is affected
+    QString reason;
+};
+
+// Columns of a streamed file. Every chunk is appended to memory-mapped temporary files as soon
+// as it is parsed, so only the pages in use are resident however long the sweep is.
+struct StreamedColumns
+{
+    MatrixStore frequencies {MatrixStore::FileOnly};
+    MatrixStore lsValues {MatrixStore::FileOnly};
+    MatrixStore rsValues {MatrixStore::FileOnly};
+};
+
+// Parsed data of one FREQUENCY,Ls,Rs sweep file
+struct CsvParseResult
+{
+    enum Status
+    {
+        Ok,
+        OpenFailed,
+        InvalidFormat,
+        Cancelled
+    };
+
+    QString filePath;
+    Status status = Ok;
+
+    // Quarantined rows, the file is only rejected when none of its rows is usable
+    QVector<CsvDiagnostic> diagnostics;
+    int skippedRows = 0;
+
+    CoreColumns columns;
+    QSharedPointer<StreamedColumns> streamedColumns;	// Rows of a streamed file, columns then stays empty
+    FrequencyWindow lsWindow;
+    FrequencyWindow rsWindow;
+    ChannelSummary lsSummary;
+    ChannelSummary rsSummary;
+    quint64 contentHash = 0;	// Of the kept rows, equal for two files holding the same sweep
+
+    // Throughput
+    bool fromCache = false;
+    bool streamed = false;	// Rows were already handed out chunk by chunk
+    qint64 bytes = 0;
+    qint64 elapsedNs = 0;
+    double throughputMBps() const;
+
+    // Rows of the file, wherever they are held
+    int rowCount() const;
+    ColumnSpan frequencies() const;
+    ColumnSpan lsValues() const;
+    ColumnSpan rsValues() const;
+};
+
+// Header names of the columns a session needs, matched case-insensitively and without
+// units ("Ls (H)" matches "Ls"); the first name found in a header wins
+struct CsvSchema
+{
+    enum Column
+    {
+        Frequency,
+        Ls,
+        Rs,
+        ColumnCount
+    };
+
+    QStringList names[ColumnCount];
+
+    CsvSchema();
+};
+
+// Zero-copy CSV reader: maps the file and converts the fields in place
+class CsvParser
+{
+public:
+    CsvParser(double minFrequencyLS, double maxFrequencyLS, double minFrequencyRS, double maxFrequencyRS);
+
+    // Receives the rows of one chunk while a file is streamed, return false to stop
+    typedef std::function<bool (const CoreColumns &chunk)> ChunkHandler;
+
+    void setSchema(const CsvSchema &schema);
+
+    CsvParseResult parseFile(const QString &filePath) const;
+    CsvParseResult parseStream(const QString &filePath, qint64 chunkBytes, const ChunkHandler &handler) const;
+    CsvParseResult parseMemory(const QString &filePath, const char *data, qint64 size) const;
+    void parseBuffer(const char *data, qint64 size, CsvParseResult &result) const;
+
+    static bool isCompressed(const QString &filePath);
+
+private:
+    friend class CsvCache;
+
+    // Progress through the lines of one file
+    struct LineState
+    {
+        int lineNumber = 1;	// The header is line 1
+        qint64 validRows = 0;
+        qint64 rows = 0;	// Valid rows inside the windows
+        double lastFrequency = 0.0;
+        bool sorted = true;	// Kept rows are in frequency order
+
+        // Every valid row so far in frequency order, the rest of the sweep lies above
+        double previousFrequency = 0.0;
+        bool ascending = true;
+        bool finished = false;	// Past both windows, nothing more to read
+        quint64 rowHashSum = 0;	// Summed so the row order does not change the content hash
+
+        // Field position of every needed column
+        int fieldIndex[CsvSchema::ColumnCount] = { 0, 1, 2 };
+
+        // Dialect found in the first lines
+        char delimiter = ',';
+        bool decimalComma = false;
+    };
+
+    const char *readHeader(const char *cursor, const char *end, LineState &state, CsvParseResult &result) const;
+    void parseDevice(QIODevice &device, qint64 chunkBytes, const ChunkHandler &handler, CsvParseResult &result) const;
+    void parseLines(const char *cursor, const char *end, LineState &state, CoreColumns &columns, CsvParseResult &result) const;
+    void finishColumns(const LineState &state, CsvParseResult &result) const;
+
+    double minFrequencyLS;
+    double maxFrequencyLS;
+    double minFrequencyRS;
+    double maxFrequencyRS;
+    CsvSchema schema;
+};
+
+#endif // CSVPARSER_H
@@ -0,0 +1,36 @@
+#ifndef CSVSCANNER_H
+#define CSVSCANNER_H
+
+#include <QtGlobal>
+
+// Finds the field delimiters and line ends of a CSV block in one pass, using the widest
+// vector instructions the CPU supports
+class CsvScanner
+{
+public:
+    enum Path
+    {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    explicit CsvScanner(char delimiter = ',', Path path = bestPath());
+
+    static Path bestPath();
+    static bool isSupported(Path path);
+    static const char *pathName(Path path);
+
+    char delimiter() const { return fieldDelimiter; }
+    Path path() const { return scanPath; }
+
+    // Offset of every delimiter and '\n' in [data, data + size), positions must hold size entries.
+    // Returns the number of offsets written.
+    int scan(const char *data, int size, quint32 *positions) const;
+
+private:
+    char fieldDelimiter;
+    Path scanPath;
+};
+
+#endif // CSVSCANNER_H
@@ -22,6 +22,14 @@
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QMessageBox>
+#include <QActionGroup>
+#include "statkernels.h"
+
+namespace
+{
+    // Vector kernels of the averages and distance ratios, on the widest path the CPU runs
+    const StatKernels statKernels;
+}
 
 // Setup Plot
 void MainWindow::setupPlot()
@@ -74,6 +82,54 @@ void MainWindow::setupPlot()
     }
 }
 
+// Settings -> Frequency Grid, used from the next load on since the grid is made from its first core,
+// the lowest slot with data in the channel
+void MainWindow::setupGridMenu()
+{
+    QMenu *gridMenu = ui->menuSettings->addMenu("Frequency Grid");
+
+    // Spacing of the grid shared by the cores
+    QActionGroup *spacingGroup = new QActionGroup(gridMenu);
+    const QList<QPair<QString, GridOptions::Spacing>> spacings = {
+        {"Sweep of the First Core", GridOptions::FirstCore},
+        {"Linear Spacing", GridOptions::LinearSpacing},
+        {"Log Spacing", GridOptions::LogSpacing}
+    };
+
+    for (const QPair<QString, GridOptions::Spacing> &spacing: spacings)
+    {
+        QAction *action = gridMenu->addAction(spacing.first);
+        action->setCheckable(true);
+        action->setChecked(spacing.second == gridSpacing);
+        spacingGroup->addAction(action);
+        connect(action, &QAction::triggered, this, [=]()
+                {
+                    gridSpacing = spacing.second;
+                });
+    }
+
+    gridMenu->addSeparator();
+
+    // Interpolation of the cores swept on other frequencies
+    QActionGroup *interpolationGroup = new QActionGroup(gridMenu);
+    const QList<QPair<QString, GridOptions::Interpolation>> interpolations = {
+        {"Linear Interpolation", GridOptions::Linear},
+        {"Spline Interpolation", GridOptions::Spline}
+    };
+
+    for (const QPair<QString, GridOptions::Interpolation> &interpolation: interpolations)
+    {
+        QAction *action = gridMenu->addAction(interpolation.first);
+        action->setCheckable(true);
+        action->setChecked(interpolation.second == gridInterpolation);
+        interpolationGroup->addAction(action);
+        connect(action, &QAction::triggered, this, [=]()
+                {
+                    gridInterpolation = interpolation.second;
+                });
+    }
+}
+
 // Clear Everything
 void MainWindow::clearEverything()
 {
@@ -83,13 +139,13 @@ void MainWindow::clearEverything()
         ui->Plot->graph(x)->data()->clear();
     }
 
-    loadedCSVLS.resize(0);
-    loadedCSVRS.resize(0);
+    dataset.clear();
 
     ui->Plot->legend->clearItems();
 
     // Clear Graphs
     ui->Plot->clearGraphs();
+    graphRegistry.clear();
 
     // Reset the x-axis range to start from 0
     ui->Plot->replot();
@@ -106,6 +162,9 @@ void MainWindow::clearEverything()
     ui->Plot->replot();
 
     avg = false;
+    averageSumsLs.clear();
+    averageSumsRs.clear();
+    clearHistory();
 }
 
 // Right Click Context Menu
@@ -116,9 +175,18 @@ void MainWindow::contextMenuRequest(const QPoint &pos)
     graphMenu->setAttribute(Qt::WA_DeleteOnClose);
 
     // Add actions for each legend item and create checkboxes for them
+    bool useLsData = ui->radioButton_Ls->isChecked();
     for (int i = 0; i < ui->Plot->graphCount(); ++i)
     {
         QCPGraph *graph = ui->Plot->graph(i);
+
+        // The graphs of the other channel are not on screen
+        const GraphRegistry::Entry *entry = graphRegistry.entry(graph);
+        if (entry && entry->useLsData != useLsData)
+        {
+            continue;
+        }
+
         if (graph)
         {
             // Create a checkable action for each graph
@@ -268,14 +336,16 @@ void MainWindow::onGraphVisibilityChanged(bool checked)
     QAction *graphAction = qobject_cast<QAction*> (sender());
     if (graphAction)
     {
+        recordStep();
+
         // Check if the graph action corresponds to the average graph
         bool isAverageGraph = graphAction == averageGraphActionLs || graphAction == averageGraphActionRs;
 
         if (isAverageGraph)
         {
-            // Update the visibility of the average graph
+            // Update the visibility of the average graph, from the running sums once they are kept
             bool useLsData = ui->radioButton_Ls->isChecked();
-            QVector<double> averageValues = calculateAverageValues(useLsData, true);	// or false, depending on your needs
+            QVector<double> averageValues = avg ? (useLsData ? averageSumsLs : averageSumsRs).average() : calculateAverageValues(useLsData, true);
 
             if (graphAction == averageGraphActionLs)
             {
@@ -304,37 +374,18 @@ void MainWindow::onGraphVisibilityChanged(bool checked)
                 }
 
                 qDebug() << "Graph visibility changed: " << graph->name() << " -> " << (checked ? "Visible" : "Hidden");
-            }
-        }
-
-        bool useLSData = ui->radioButton_Ls->isChecked();
 
-        if (useLSData)
-        {
-            for (int i = 0; i < loadedCSVLS.size(); ++i)
-            {
-                QCPGraph *graph = ui->Plot->graph(i);
-                if (graph)
+                // Only the toggled core moves the average, its row is added to or taken from the sums
+                const GraphRegistry::Entry *entry = graphRegistry.entry(graph);
+                if (entry && entry->role == GraphRole::Core)
                 {
-                    loadedCSVLS[i].visible = graph->visible();
+                    setCoreVisible(entry->useLsData, entry->core, checked);
+                    updateAverageGraph();
                 }
             }
-
-            ui->Plot->replot();
         }
-        else
-        {
-            for (int i = 0; i < loadedCSVRS.size(); ++i)
-            {
-                QCPGraph *graph = ui->Plot->graph(i);
-                if (graph)
-                {
-                    loadedCSVRS[i].visible = graph->visible();
-                }
-            }
 
-            ui->Plot->replot();
-        }
+        ui->Plot->replot();
     }
 }
 
@@ -342,10 +393,6 @@ void MainWindow::onGraphVisibilityChanged(bool checked)
 void MainWindow::calculateDistanceRatios()
 {
     qDebug() << "Calculating distance ratios...";
-    bool distanceRatiosCalculated = false;
-
-    double maxDistanceRatio = 0.0;
-    distanceRatios.clear();
 
     bool useLsData = ui->radioButton_Ls->isChecked();
     qDebug() << "Using" << (useLsData ? "LS" : "RS") << "data for calculations.";
@@ -370,180 +417,64 @@ void MainWindow::calculateDistanceRatios()
         addAverageGraph(averageValues, useLsData);
     }
 
+    calculateDistanceRatios(averageValues);
+}
+
+// Calculating DistanceRatio against a given average
+void MainWindow::calculateDistanceRatios(const QVector<double> &averageValues)
+{
+    bool distanceRatiosCalculated = false;
+
+    double maxDistanceRatio = 0.0;
+    distanceRatios.clear();
+
+    bool useLsData = ui->radioButton_Ls->isChecked();
+    const ChannelMatrix &matrix = dataset.channel(useLsData);
+
     // If distance ratios not calculated, then calculate
     if (!distanceRatiosCalculated)
     {
-        if (useLsData)
+        // Mean distance of every included core to the average, each row is contiguous
+        QVector<double> averageDifferences(matrix.coreCount(), 0.0);
+        for (int i = 0; i < matrix.coreCount(); ++i)
         {
-            qDebug() << " YOU ARE IN";
-
-            for (const CSVInfo &fileInfo: loadedCSVLS)
+            if (!matrix.isVisible(i))
             {
-                if (!fileInfo.visible)
-                {
-                    continue;
-                }
-
-                const QVector<double> &data = useLsData ? fileInfo.lsValues : fileInfo.rsValues;
-
-                double sumDifference = 0.0;
-                int visibleDataPoints = 0;
-
-                for (int j = 0; j < data.size(); ++j)
-                {
-                    if (fileInfo.visible)
-                    {
-                        double difference = std::abs(data[j] - averageValues[j]);
-                        sumDifference += difference;
-                        ++visibleDataPoints;
-                    }
-                }
-
-                double averageDifference = (visibleDataPoints > 0) ? sumDifference / visibleDataPoints : 0.0;
-
-                // Calculate the distance ratio as a proportion of the average difference
-                double ratioArray = averageDifference;
-                if (ratioArray > maxDistanceRatio)
-                {
-                    maxDistanceRatio = ratioArray;
-                }
+                continue;
             }
 
-            for (const CSVInfo &fileInfo: loadedCSVLS)
-            {
-                if (!fileInfo.visible)
-                {
-                    distanceRatio = 101.10;
-                    distanceRatios.push_back(distanceRatio);
-
-                    qDebug() << "-------------------------------";
-                    qDebug() << "Graph:" << fileInfo.fileName;
-                    qDebug() << "Not included ";
-                    qDebug() << "Distance Ratio:" << distanceRatio;
-                    qDebug() << "-------------------------------";
-
-                    continue;
-                }
+            const ColumnSpan data = matrix.core(i);
+            int count = qMin(data.size(), averageValues.size());
 
-                const QVector<double> &data = useLsData ? fileInfo.lsValues : fileInfo.rsValues;
+            int points = 0;
+            double sumDifference = statKernels.absoluteDifference(data.begin(), averageValues.constData(), count, &points);
 
-                double sumDifference = 0.0;
-                int visibleDataPoints = 0;
+            averageDifferences[i] = (points > 0) ? sumDifference / points : 0.0;
 
-                for (int j = 0; j < data.size(); ++j)
-                {
-                    if (fileInfo.visible)
-                    {
-                        double difference = std::abs(data[j] - averageValues[j]);
-                        sumDifference += difference;
-                        ++visibleDataPoints;
-                    }
-                }
-
-                double averageDifference = (visibleDataPoints > 0) ? sumDifference / visibleDataPoints : 0.0;
-
-                // Calculate the distance ratio as a proportion of the maximum difference
-                double distanceRatio = averageDifference / maxDistanceRatio;
-
-                distanceRatios.push_back(distanceRatio);
-
-                qDebug() << "-------------------------------";
-                qDebug() << "Graph:" << fileInfo.fileName;
-                qDebug() << "Visible Data Points:" << visibleDataPoints;
-                qDebug() << "Sum Difference:" << sumDifference;
-                qDebug() << "Average Difference:" << averageDifference;
-                qDebug() << "Distance Ratio:" << distanceRatio;
-                qDebug() << "-------------------------------";
-            }
-
-            qDebug() << "Max Distance Ratio:" << maxDistanceRatio;
-            qDebug() << "-------------------------------";
-        }
-        else
-        {
-            qDebug() << " YOU ARE IN";
-            for (const CSVInfo2 &fileInfo2RS: loadedCSVRS)
+            // Calculate the distance ratio as a proportion of the average difference
+            if (averageDifferences[i] > maxDistanceRatio)
             {
-                if (!fileInfo2RS.visible)
-                {
-                    continue;
-                }
-
-                const QVector<double> &data = useLsData ? fileInfo2RS.lsValues : fileInfo2RS.rsValues;
-
-                double sumDifference = 0.0;
-                int visibleDataPoints = 0;
-
-                for (int j = 0; j < data.size(); ++j)
-                {
-                    if (fileInfo2RS.visible)
-                    {
-                        double difference = std::abs(data[j] - averageValues[j]);
-                        sumDifference += difference;
-                        ++visibleDataPoints;
-                    }
-                }
-
-                double averageDifference = (visibleDataPoints > 0) ? sumDifference / visibleDataPoints : 0.0;
-
-                // Calculate the distance ratio as a proportion of the average difference
-                double ratioArray = averageDifference;
-                if (ratioArray > maxDistanceRatio)
-                {
-                    maxDistanceRatio = ratioArray;
-                }
+                maxDistanceRatio = averageDifferences[i];
             }
+        }
 
-            for (const CSVInfo2 &fileInfo2RS: loadedCSVRS)
+        for (int i = 0; i < matrix.coreCount(); ++i)
+        {
+            if (!matrix.isVisible(i))
             {
-                if (!fileInfo2RS.visible)
-                {
-                    distanceRatio = 101.10;
-                    distanceRatios.push_back(distanceRatio);
-
-                    qDebug() << "-------------------------------";
-                    qDebug() << "Graph:" << fileInfo2RS.fileName;
-                    qDebug() << "Not included ";
-                    qDebug() << "Distance Ratio:" << distanceRatio;
-                    qDebug() << "-------------------------------";
-
-                    continue;
-                }
-
-                const QVector<double> &data = useLsData ? fileInfo2RS.lsValues : fileInfo2RS.rsValues;
-
-                double sumDifference = 0.0;
-                int visibleDataPoints = 0;
-
-                for (int j = 0; j < data.size(); ++j)
-                {
-                    if (fileInfo2RS.visible)
-                    {
-                        double difference = std::abs(data[j] - averageValues[j]);
-                        sumDifference += difference;
-                        ++visibleDataPoints;
-                    }
-                }
-
-                double averageDifference = (visibleDataPoints > 0) ? sumDifference / visibleDataPoints : 0.0;
-
-                // Calculate the distance ratio as a proportion of the maximum difference
-                double distanceRatio = averageDifference / maxDistanceRatio;
-
+                distanceRatio = 101.10;
                 distanceRatios.push_back(distanceRatio);
-
-                qDebug() << "-------------------------------";
-                qDebug() << "Graph:" << fileInfo2RS.fileName;
-                qDebug() << "Visible Data Points:" << visibleDataPoints;
-                qDebug() << "Sum Difference:" << sumDifference;
-                qDebug() << "Average Difference:" << averageDifference;
-                qDebug() << "Distance Ratio:" << distanceRatio;
-                qDebug() << "-------------------------------";
+                continue;
             }
 
-            qDebug() << "Max Distance Ratio:" << maxDistanceRatio;
-            qDebug() << "-------------------------------";
+            // Calculate the distance ratio as a proportion of the maximum difference
+            double distanceRatio = averageDifferences[i] / maxDistanceRatio;
+
+            distanceRatios.push_back(distanceRatio);
         }
+
+        // A summary only, a few lines per core would cost more than the kernels at thousands of cores
+        qDebug() << "Distance ratios of" << distanceRatios.size() << "cores, max average difference" << maxDistanceRatio;
     }
 
     // Replot the graph
@@ -555,7 +486,7 @@ void MainWindow::calculateDistanceRatios()
 void MainWindow::on_btn_HighlightGraphs_clicked()
 {
     // If empty -> return
-    if (loadedCSVRS.isEmpty() && loadedCSVLS.isEmpty())
+    if (dataset.isEmpty())
     {
         QMessageBox::warning(this, "Warning", "No CSV data loaded. Load CSV files first.");
         return;
@@ -568,18 +499,7 @@ void MainWindow::on_btn_HighlightGraphs_clicked()
     }
 
     // If there are no AverageGraph -> return
-    int averageGraphIndex = -1;
-    for (int i = 0; i < ui->Plot->graphCount(); ++i)
-    {
-        QCPGraph *graph = ui->Plot->graph(i);
-        if (graph && (graph->name() == "Average LS" || graph->name() == "Average RS"))
-        {
-            averageGraphIndex = i;
-            break;
-        }
-    }
-
-    if (averageGraphIndex == -1)
+    if (averageGraph() == nullptr)
     {
         QMessageBox::warning(this, "Warning", "There is no Average Graph. Calculate Average Graph first.");
         return;	// Handle the case where the average graph is not found
@@ -590,64 +510,37 @@ void MainWindow::on_btn_HighlightGraphs_clicked()
 
     qDebug() << "your percentege " << thresholdPercentage;
 
-    if (ui->radioButton_Ls->isChecked())
-    {
-        // For LS
-        for (int i = 0; i < loadedCSVLS.size(); ++i)
-        {
-            CSVInfo &fileInfo = loadedCSVLS[i];
+    recordStep();
 
-            // Determine if the graph should be visible or hidden based on the threshold value
-            bool isVisible = (distanceRatios[i] <= thresholdPercentage);
-            fileInfo.visible = isVisible;
+    bool useLsData = ui->radioButton_Ls->isChecked();
+    ChannelMatrix &matrix = dataset.channel(useLsData);
+    int visibleCores = 0;
+    for (int i = 0; i < matrix.coreCount(); ++i)
+    {
+        // Determine if the graph should be visible or hidden based on the threshold value
+        bool isVisible = (distanceRatios[i] <= thresholdPercentage);
+        visibleCores += isVisible;
+        setCoreVisible(useLsData, i, isVisible);
 
-            QCPGraph *graph = ui->Plot->graph(i);
-            if (graph)
+        QCPGraph *graph = coreGraph(useLsData, i);
+        if (graph)
+        {
+            graph->setVisible(isVisible);
+            if (!isVisible)
             {
-                graph->setVisible(isVisible);
-                if (!isVisible)
-                {
-                    graph->removeFromLegend();
-                }
-                else
-                {
-                    graph->addToLegend();
-                }
+                graph->removeFromLegend();
             }
-
-            qDebug() << "Graph" << i + 1 << (isVisible ? "Visible" : "Hidden");
-        }
-    }
-    else
-    {
-        // For RS
-        for (int i = 0; i < loadedCSVRS.size(); ++i)
-        {
-            CSVInfo2 &fileInfo2RS = loadedCSVRS[i];
-
-            // Determine if the graph should be visible or hidden based on the threshold value
-            bool isVisible = (distanceRatios[i] <= thresholdPercentage);
-            fileInfo2RS.visible = isVisible;
-
-            QCPGraph *graph = ui->Plot->graph(i);
-            if (graph)
+            else
             {
-                graph->setVisible(isVisible);
-                if (!isVisible)
-                {
-                    graph->removeFromLegend();
-                }
-                else
-                {
-                    graph->addToLegend();
-                }
+                graph->addToLegend();
             }
-
-            qDebug() << "Graph" << i + 1 << (isVisible ? "Visible" : "Hidden");
         }
     }
 
+    qDebug() << "Highlight kept" << visibleCores << "of" << matrix.coreCount() << "cores";
+
     // Replot the graph
+    updateAverageGraph();
     ui->Plot->replot();
 }
 
@@ -663,7 +556,7 @@ void MainWindow::on_tracerShowPointValue(QMouseEvent *event)	// Tracer Showing V
         QCPGraph *graph = nullptr;
         for (auto i = 0; i < ui->Plot->graphCount(); ++i)
         {
-            if (ui->Plot->graph(i)->selected())
+            if (ui->Plot->graph(i)->visible() && ui->Plot->graph(i)->selected())
             {
                 graph = ui->Plot->graph(i);
                 break;
@@ -673,9 +566,20 @@ void MainWindow::on_tracerShowPointValue(QMouseEvent *event)	// Tracer Showing V
         if (graph == nullptr)
             return;
 
+        // Point of the graph nearest the cursor, read through the 1D interface since the
+        // core graphs draw from the dataset and keep no QCPGraphData of their own
+        QCPPlottableInterface1D *points = graph->interface1D();
+        double key = ui->Plot->xAxis->pixelToCoord(event->pos().x());
+        int index = points->findBegin(key, false);
+        if (index > 0 && (index == points->dataCount() || key - points->dataMainKey(index - 1) <= points->dataMainKey(index) - key))
+            --index;
+        if (index >= points->dataCount())
+            return;
+
         // Setup the item tracer
-        this->phaseTracer->setGraph(graph);
-        this->phaseTracer->setGraphKey(ui->Plot->xAxis->pixelToCoord(event->pos().x()));
+        this->phaseTracer->setGraph(nullptr);
+        this->phaseTracer->position->setAxes(graph->keyAxis(), graph->valueAxis());
+        this->phaseTracer->position->setCoords(points->dataMainKey(index), points->dataMainValue(index));
         ui->Plot->replot();
         bool useLsData = ui->radioButton_Ls->isChecked();
 
@@ -739,7 +643,7 @@ void MainWindow::on_btn_clear_plot_clicked()
 // Button -> Export Graph as PNG
 void MainWindow::on_btn_save_plot_clicked()	// Export Graph PNG
 {
-    if (loadedCSVRS.isEmpty() && loadedCSVLS.isEmpty())
+    if (dataset.isEmpty())
     {
         QMessageBox::warning(this, "Warning", "No CSV data loaded. Load CSV files first.");
         return;
@@ -761,12 +665,21 @@ void MainWindow::on_btn_save_plot_clicked()	// Export Graph PNG
 // Button -> Default
 void MainWindow::on_btn_start_plot_clicked()
 {
-    if (loadedCSVRS.isEmpty() && loadedCSVLS.isEmpty())
+    if (dataset.isEmpty())
     {
         QMessageBox::warning(this, "Warning", "No CSV data loaded. Load CSV files first.");
         return;
     }
 
+    recordStep();
+
+    // Show every core of the channel again
+    bool useLsData = ui->radioButton_Ls->isChecked();
+    for (int i = 0; i < dataset.channel(useLsData).coreCount(); ++i)
+    {
+        setCoreVisible(useLsData, i, true);
+    }
+
     if (ui->radioButton_Ls->isChecked())
     {
         on_radioButton_Ls_clicked();
@@ -780,13 +693,15 @@ void MainWindow::on_btn_start_plot_clicked()
 // Button -> Calculate Average Graph
 void MainWindow::on_btn_avg_clicked()
 {
-    if (loadedCSVRS.isEmpty() && loadedCSVLS.isEmpty())
+    if (dataset.isEmpty())
     {
         QMessageBox::warning(this, "Warning", "No CSV data loaded. Load CSV files first.");
         return;
         avg = false;
     }
 
+    recordStep();
+
     QVector<double> averageRSValues = calculateAverageValues(false, true);
     qDebug() << "Calculated Average RS ";
     QVector<double> averageLSValues = calculateAverageValues(true, true);
@@ -810,89 +725,32 @@ void MainWindow::on_btn_avg_clicked()
 // LS - View
 void MainWindow::on_radioButton_Ls_clicked()
 {
-    // Define the number of graphs
-    int graphCount = loadedCSVLS.size();
-    qDebug() << graphCount;
+    qDebug() << dataset.coreCount();
 
-    // Generate a color palette with the desired number of colors
-    QList<QColor> graphColors = generateColorPalette(graphCount);
-    qDebug() << "Color Palette generated.";
-
-    // Clear the previous data from the graph
-    ui->Plot->clearGraphs();
-
-    // Add Ls data to the plot as a new graph
-    for (int i = 0; i < loadedCSVLS.size(); ++i)
-    {
-        CSVInfo &fileInfo = loadedCSVLS[i];
-        fileInfo.visible = true;
-
-        if (fileInfo.visible)
-        {
-            ui->Plot->addGraph();
-            qDebug() << "Added LS Graph succesfully";
-            ui->Plot->graph(i)->setPen(QPen(graphColors[i]));	// Set the pen color for Ls graph
-            ui->Plot->graph(i)->setData(fileInfo.frequenciesLs, fileInfo.lsValues);
-            ui->Plot->graph(i)->setName(fileInfo.fileName);
-            // Add scatter style for the data points
-            QCPScatterStyle scatterStyle;
-            scatterStyle.setShape(QCPScatterStyle::ssCircle);	// Circle shape
-            scatterStyle.setPen(QPen(Qt::black));	// Black outline
-            scatterStyle.setBrush(QBrush(graphColors[i]));	// Blue interior with 100 transparency
-            scatterStyle.setSize(8);
-
-            ui->Plot->graph(i)->setScatterStyle(scatterStyle);
-        }
-    }
+    // Show the Ls graphs, the Rs ones stay on the plot hidden
+    showChannel(true);
 
     // Set labels for x and y axes
     ui->Plot->xAxis->setLabel("FREQUENCY");
     ui->Plot->yAxis->setLabel("Ls");
 
     // Rescale and replot the graph
-    ui->Plot->rescaleAxes();
+    rescaleToCores(true);
     ui->Plot->replot();
 }
 
 // RS - View
 void MainWindow::on_radioButton_Rs_clicked()
 {
-    // Define the number of graphs
-    int graphCount = loadedCSVRS.size();
-
-    // Generate a color palette with the desired number of colors
-    QList<QColor> graphColors = generateColorPalette(graphCount);
-
-    // Clear the previous data from the graph
-    ui->Plot->clearGraphs();
-
-    // Add Rs data to the plot as a new graph
-    for (int i = 0; i < loadedCSVRS.size(); ++i)
-    {
-        CSVInfo2 &fileInfo = loadedCSVRS[i];
-        fileInfo.visible = true;
-        if (fileInfo.visible)
-        {
-            ui->Plot->addGraph();
-            qDebug() << "Added RS Graph succesfully";
-            ui->Plot->graph(i)->setPen(QPen(graphColors[i]));	// Set the pen color for Rs graph
-            ui->Plot->graph(i)->setData(fileInfo.frequenciesRs, fileInfo.rsValues);
-            ui->Plot->graph(i)->setName(fileInfo.fileName);
-            QCPScatterStyle scatterStyle;
-            scatterStyle.setShape(QCPScatterStyle::ssCircle);	// Circle shape
-            scatterStyle.setPen(QPen(Qt::black));	// Black outline
-            scatterStyle.setBrush(QBrush(graphColors[i]));	// Red interior with 100 transparency
-            scatterStyle.setSize(8);
-            ui->Plot->graph(i)->setScatterStyle(scatterStyle);
-        }
-    }
+    // Show the Rs graphs, the Ls ones stay on the plot hidden
+    showChannel(false);
 
     // Set labels for x and y axes
     ui->Plot->xAxis->setLabel("FREQUENCY");
     ui->Plot->yAxis->setLabel("Rs");
 
     // Rescale and replot the graph
-    ui->Plot->rescaleAxes();
+    rescaleToCores(false);
     ui->Plot->replot();
 
 }
@@ -900,151 +758,76 @@ void MainWindow::on_radioButton_Rs_clicked()
 // Calculating Average Values
 QVector<double> MainWindow::calculateAverageValues(bool useLsData, bool onlyVisibleGraphs)
 {
-    QVector<double> averageValues;
-    int numFiles = 0;
+    const ChannelMatrix &matrix = dataset.channel(useLsData);
 
-    // Initialize the averageValues vector with zeros
-    if (useLsData)
+    // Sum the rows of the cores taken into the average, row by row through the matrix
+    AverageSums sums;
+    int usedCores = 0;
+    for (int i = 0; i < matrix.coreCount(); ++i)
     {
-        if (!loadedCSVLS.isEmpty())
+        if (!onlyVisibleGraphs || matrix.isVisible(i))
         {
-            for (int i = 0; i < loadedCSVLS[0].frequenciesLs.size(); ++i)
-            {
-                averageValues.append(0.0);
-            }
-
-            if (onlyVisibleGraphs)
-            {
-                // Calculate the sum of values for each frequency only for visible graphs
-                for (const CSVInfo &fileInfo: loadedCSVLS)
-                {
-                    if (fileInfo.visible)
-                    {
-                        const QVector<double> &data = fileInfo.lsValues;
-                        for (int i = 0; i < data.size(); ++i)
-                        {
-                            averageValues[i] += data[i];
-                        }
-
-                        numFiles++;
-                    }
-                }
-            }
-            else
-            {
-                // Calculate the sum of values for each frequency for all graphs
-                for (const CSVInfo &fileInfo: loadedCSVLS)
-                {
-                    const QVector<double> &data = fileInfo.lsValues;
-                    for (int i = 0; i < data.size(); ++i)
-                    {
-                        averageValues[i] += data[i];
-                    }
-
-                    numFiles++;
-                }
-            }
+            sums.add(matrix.core(i));
+            ++usedCores;
         }
+    }
 
-        // Calculate the average values by dividing the sum by the number of files
-        if (numFiles > 0)
-        {
-            for (int i = 0; i < averageValues.size(); ++i)
-            {
-                averageValues[i] /= numFiles;
-            }
-        }
+    // Keep the sums so added cores can be folded in later
+    if (onlyVisibleGraphs)
+    {
+        (useLsData ? averageSumsLs : averageSumsRs) = sums;
+    }
 
-        // Add debug statements to print which graphs are being used for calculation
-        qDebug() << "Calculating average values using " << (useLsData ? "LS" : "RS") << " data:";
-        for (int i = 0; i < loadedCSVLS.size(); ++i)
-        {
-            if (loadedCSVLS[i].visible)
-            {
-                qDebug() << "Graph " << (i + 1) << " is used in calculation.";
-            }
-        }
+    // One line per calculation, a line per core would cost more than the sums at thousands of cores
+    qDebug() << "Calculated the" << (useLsData ? "LS" : "RS") << "average of" << usedCores << "cores";
+
+    return sums.average();
+}
 
-        return averageValues;
+// Add one core to the sums
+void AverageSums::add(const ColumnSpan &values)
+{
+    if (values.isEmpty())
+    {
+        return;
     }
-    else
+
+    if (sums.isEmpty())
     {
-        if (!loadedCSVRS.isEmpty())
-        {
-            for (int i = 0; i < loadedCSVRS[0].frequenciesRs.size(); ++i)
-            {
-                averageValues.append(0.0);
-            }
+        sums.fill(0.0, values.size());
+        counts.fill(0, values.size());
+    }
 
-            if (onlyVisibleGraphs)
-            {
-                // Calculate the sum of values for each frequency only for visible graphs
-                for (const CSVInfo2 &fileInfo2RS: loadedCSVRS)
-                {
-                    if (fileInfo2RS.visible)
-                    {
-                        const QVector<double> &data = fileInfo2RS.rsValues;
-                        for (int i = 0; i < data.size(); ++i)
-                        {
-                            averageValues[i] += data[i];
-                        }
-
-                        numFiles++;
-                    }
-                }
-            }
-            else
-            {
-                // Calculate the sum of values for each frequency for all graphs
-                for (const CSVInfo2 &fileInfo2RS: loadedCSVRS)
-                {
-                    const QVector<double> &data = fileInfo2RS.rsValues;
-                    for (int i = 0; i < data.size(); ++i)
-                    {
-                        averageValues[i] += data[i];
-                    }
+    // Points a core does not cover are NaN and are left out
+    statKernels.accumulate(values.begin(), qMin(sums.size(), values.size()), sums.data(), counts.data());
+}
 
-                    numFiles++;
-                }
-            }
-        }
+// Take one core back out of the sums, a frequency no core is counted at any more restarts from zero
+void AverageSums::remove(const ColumnSpan &values)
+{
+    if (values.isEmpty() || sums.isEmpty())
+    {
+        return;
+    }
 
-        // Calculate the average values by dividing the sum by the number of files
-        if (numFiles > 0)
-        {
-            for (int i = 0; i < averageValues.size(); ++i)
-            {
-                averageValues[i] /= numFiles;
-            }
-        }
+    // Adding and taking out rounds, an empty frequency must not keep the residue
+    statKernels.subtract(values.begin(), qMin(sums.size(), values.size()), sums.data(), counts.data());
+}
 
-        // Add debug statements to print which graphs are being used for calculation
-        qDebug() << "Calculating average values using " << (useLsData ? "LS" : "RS") << " data:";
-        for (int i = 0; i < loadedCSVRS.size(); ++i)
-        {
-            if (loadedCSVRS[i].visible)
-            {
-                qDebug() << "Graph " << (i + 1) << " is used in calculation.";
-            }
-        }
+// Average of the cores added so far
+QVector<double> AverageSums::average() const
+{
+    QVector<double> averageValues(sums.size());
+    statKernels.mean(sums.constData(), counts.constData(), sums.size(), averageValues.data());
 
-        return averageValues;
-    }
+    return averageValues;
 }
 
 // Creating and Adding Average Graph
 void MainWindow::addAverageGraph(const QVector<double> &averageValues, bool useLsData)
 {
     // First, remove the previous average graph (if exists)
-    for (int i = 0; i < ui->Plot->graphCount(); ++i)
-    {
-        QCPGraph *graph = ui->Plot->graph(i);
-        if (graph->name() == "Average LS" || graph->name() == "Average RS")
-        {
-            ui->Plot->removeGraph(graph);
-            break;	// Assuming there's only one average graph, so we break the loop after removing it.
-        }
-    }
+    removeAverageGraphs();
 
     // Add the average data to the plot as a new graph
     QCPGraph *averageGraph = ui->Plot->addGraph();
@@ -1053,19 +836,18 @@ void MainWindow::addAverageGraph(const QVector<double> &averageValues, bool useL
     averageGraph->setPen(QPen(Qt::black));
 
     // Set the data for the average graph
+    setGraphData(averageGraph, dataset.channel(useLsData).frequencies(), averageValues);
     if (useLsData)
     {
-        averageGraph->setData(loadedCSVLS[0].frequenciesLs, averageValues);
         averageGraph->setName("Average LS");
-        averageGraphLs = averageGraph;
     }
     else
     {
-        averageGraph->setData(loadedCSVRS[0].frequenciesRs, averageValues);
         averageGraph->setName("Average RS");
-        averageGraphRs = averageGraph;
     }
 
+    graphRegistry.add(averageGraph, GraphRole::Average, useLsData);
+
     // Set the scatter style for the data points of the average graph
     QCPScatterStyle scatterStyle;
     scatterStyle.setShape(QCPScatterStyle::ssCircle);	// Circle shape
@@ -1078,46 +860,247 @@ void MainWindow::addAverageGraph(const QVector<double> &averageValues, bool useL
     ui->Plot->xAxis->setLabel("FREQUENCY");
     ui->Plot->yAxis->setLabel(useLsData ? "LS Average" : "RS Average");
 
-    // Rescale and replot the graph
-    ui->Plot->rescaleAxes();
+    // Rescale and replot the graph, the average lies inside the range of the cores
+    rescaleToCores(useLsData);
     ui->Plot->replot();
 }
 
+// The average on the plot, of whichever channel it was calculated for
+QCPGraph *MainWindow::averageGraph() const
+{
+    QCPGraph *graph = graphRegistry.graph(GraphRole::Average, true);
+    return graph ? graph : graphRegistry.graph(GraphRole::Average, false);
+}
+
+// Redraw the average on the plot from the running sums of its channel, O(points) whatever the core count
+void MainWindow::updateAverageGraph()
+{
+    QCPGraph *graph = averageGraph();
+    if (graph == nullptr || !avg)
+    {
+        return;
+    }
+
+    bool useLsData = graphRegistry.entry(graph)->useLsData;
+    setGraphData(graph, dataset.channel(useLsData).frequencies(), (useLsData ? averageSumsLs : averageSumsRs).average());
+}
+
+// Show or hide a core in its channel, once an average is calculated its sums follow the change
+void MainWindow::setCoreVisible(bool useLsData, int core, bool isVisible)
+{
+    ChannelMatrix &matrix = dataset.channel(useLsData);
+    if (matrix.isVisible(core) == isVisible)
+    {
+        return;
+    }
+
+    matrix.setVisible(core, isVisible);
+    if (avg)
+    {
+        AverageSums &sums = useLsData ? averageSumsLs : averageSumsRs;
+        if (isVisible)
+        {
+            sums.add(matrix.core(core));
+        }
+        else
+        {
+            sums.remove(matrix.core(core));
+        }
+    }
+}
+
+// Take the averages of both channels off the plot
+void MainWindow::removeAverageGraphs()
+{
+    for (bool useLsData: {true, false})
+    {
+        QCPGraph *graph = graphRegistry.graph(GraphRole::Average, useLsData);
+        if (graph)
+        {
+            graphRegistry.remove(graph);
+            ui->Plot->removeGraph(graph);
+        }
+    }
+}
+
+// Fit the axes to every core of a channel from the parsed summaries instead of walking the graph data
+void MainWindow::rescaleToCores(bool useLsData)
+{
+    const ChannelMatrix &matrix = dataset.channel(useLsData);
+
+    ChannelSummary total;
+    for (int i = 0; i < matrix.coreCount(); ++i)
+    {
+        total.merge(matrix.summary(i));
+    }
+
+    if (total.count == 0)
+    {
+        return;
+    }
+
+    // Widen single-valued ranges the way rescaleAxes does, so the points stay visible
+    QCPRange keyRange(total.firstFrequency, total.lastFrequency);
+    if (keyRange.size() == 0.0)
+    {
+        keyRange.lower -= 0.5;
+        keyRange.upper += 0.5;
+    }
+
+    QCPRange valueRange(total.minValue, total.maxValue);
+    if (valueRange.size() == 0.0)
+    {
+        double margin = valueRange.lower != 0.0 ? qAbs(valueRange.lower) * 0.05 : 0.5;
+        valueRange.lower -= margin;
+        valueRange.upper += margin;
+    }
+
+    ui->Plot->xAxis->setRange(keyRange);
+    ui->Plot->yAxis->setRange(valueRange);
+}
+
+// Fill a graph from column slices, the keys are already sorted
+void MainWindow::setGraphData(QCPGraph *graph, const ColumnSpan &keys, const ColumnSpan &values)
+{
+    int count = qMin(keys.size(), values.size());
+
+    QVector<QCPGraphData> points(count);
+    for (int i = 0; i < count; ++i)
+    {
+        points[i].key = keys[i];
+        points[i].value = values[i];
+    }
+
+    graph->data()->set(points, true);
+}
+
+// Add the Ls and Rs graphs of every core from slot first on, coreGraph(useLsData, i) shows core i
+void MainWindow::addCoreGraphs(int first)
+{
+    int graphCount = dataset.coreCount();
+    bool showLs = ui->radioButton_Ls->isChecked();
+
+    // Generate a color palette with the desired number of colors, a core keeps its color in both channels
+    QList<QColor> graphColors = generateColorPalette(graphCount - first);
+
+    // Legend items are added here for the shown set only, auto-adding would scan the legend per graph
+    ui->Plot->setAutoAddPlottableToLegend(false);
+    for (int i = first; i < graphCount; ++i)
+    {
+        QColor color = graphColors[i - first];
+        for (bool useLsData: {true, false})
+        {
+            // The graph reads the core from the matrix, creating it copies no data. The graph object
+            // itself is still made for every core of both channels
+            ChannelMatrix &matrix = dataset.channel(useLsData);
+            CoreGraph *graph = new CoreGraph(ui->Plot->xAxis, ui->Plot->yAxis);
+            graph->setSource(&matrix, i);
+            graph->setPen(QPen(color));
+
+            matrix.setVisible(i, true);
+            graph->setName(dataset.name(i));
+
+            // Add scatter style for the data points
+            QCPScatterStyle scatterStyle;
+            scatterStyle.setShape(QCPScatterStyle::ssCircle);	// Circle shape
+            scatterStyle.setPen(QPen(Qt::black));	// Black outline
+            scatterStyle.setBrush(QBrush(color));
+            scatterStyle.setSize(8);
+            graph->setScatterStyle(scatterStyle);
+
+            graph->setVisible(useLsData == showLs);
+            if (useLsData == showLs)
+            {
+                ui->Plot->legend->addItem(new QCPPlottableLegendItem(ui->Plot->legend, graph));
+            }
+
+            graphRegistry.add(graph, GraphRole::Core, useLsData, i);
+        }
+    }
+
+    ui->Plot->setAutoAddPlottableToLegend(true);
+}
+
+// Remove the graphs of the slots in cores (ascending) from both sets
+void MainWindow::removeCoreGraphs(const QVector<int> &cores)
+{
+    QVector<QCPGraph*> removed;
+    for (int core: cores)
+    {
+        removed << coreGraph(true, core) << coreGraph(false, core);
+    }
+
+    graphRegistry.removeCores(cores);
+    for (QCPGraph *graph: removed)
+    {
+        ui->Plot->removeGraph(graph);
+    }
+}
+
+// Show the graph set of one channel and hide the other, no graph is created and no data is copied
+void MainWindow::showChannel(bool useLsData)
+{
+    // The average belongs to the channel it was calculated for
+    removeAverageGraphs();
+
+    // Each set keeps the cores hidden in its channel hidden
+    const ChannelMatrix &matrix = dataset.channel(useLsData);
+    for (int i = 0; i < matrix.coreCount(); ++i)
+    {
+        CoreGraph *hiddenGraph = coreGraph(!useLsData, i);
+        if (hiddenGraph)
+        {
+            hiddenGraph->setVisible(false);
+            hiddenGraph->setSelection(QCPDataSelection());
+        }
+
+        CoreGraph *shownGraph = coreGraph(useLsData, i);
+        if (shownGraph)
+        {
+            shownGraph->setVisible(matrix.isVisible(i));
+        }
+    }
+
+    // Rebuild the legend in one pass instead of removing items one by one
+    ui->Plot->legend->clearItems();
+    for (int i = 0; i < matrix.coreCount(); ++i)
+    {
+        CoreGraph *graph = coreGraph(useLsData, i);
+        if (graph && graph->visible())
+        {
+            ui->Plot->legend->addItem(new QCPPlottableLegendItem(ui->Plot->legend, graph));
+        }
+    }
+}
+
 // Hide Selected Graphs
 void MainWindow::hideSelectedGraph()
 {
+    recordStep();
 
     // Iterate through all graphs and hide selected ones
     for (auto i = 0; i < ui->Plot->graphCount(); ++i)
     {
         QCPGraph *graph = ui->Plot->graph(i);
-        if (graph->selected())
+        if (graph->visible() && graph->selected())
         {
             // Hide the selected graph
             graph->setVisible(false);
             graph->removeFromLegend();
 
 
-            // Update the visibility flag in the corresponding CSVInfo
-            if (ui->radioButton_Ls->isChecked())
+            // Update the visibility flag of the core in the dataset
+            const GraphRegistry::Entry *entry = graphRegistry.entry(graph);
+            if (entry && entry->role == GraphRole::Core)
             {
-                if (i < loadedCSVLS.size())
-                {
-                    loadedCSVLS[i].visible = false;
-                }
-            }
-            else
-            {
-                if (i < loadedCSVRS.size())
-                {
-                    loadedCSVRS[i].visible = false;
-                }
+                setCoreVisible(entry->useLsData, entry->core, false);
             }
         }
 
 
     }
 
+    updateAverageGraph();
     ui->Plot->replot();	// Update the plot
 }
 
@@ -1126,36 +1109,29 @@ void MainWindow::hideSelectedGraph()
 // Show Only Selected Graphs
 void MainWindow::hideUnselectedGraphs()
 {
+    recordStep();
 
 
     for (int i = 0; i < ui->Plot->graphCount(); ++i)
     {
         QCPGraph *graph = ui->Plot->graph(i);
-        if (graph && !graph->selected())
+        if (graph && graph->visible() && !graph->selected())
         {
             graph->setVisible(false);
             graph->removeFromLegend();
 
 
-            // Update the visibility flag in the corresponding CSVInfo
-            if (ui->radioButton_Ls->isChecked())
+            // Update the visibility flag of the core in the dataset
+            const GraphRegistry::Entry *entry = graphRegistry.entry(graph);
+            if (entry && entry->role == GraphRole::Core)
             {
-                if (i < loadedCSVLS.size())
-                {
-                    loadedCSVLS[i].visible = false;
-                }
-            }
-            else
-            {
-                if (i < loadedCSVRS.size())
-                {
-                    loadedCSVRS[i].visible = false;
-                }
+                setCoreVisible(entry->useLsData, entry->core, false);
             }
         }
 
     }
 
+    updateAverageGraph();
     ui->Plot->replot();	// Update the plot
 }
 
@@ -1269,6 +1245,8 @@ void MainWindow::on_btn_addValue_clicked()
 {
     if (ui->cbox_Lines->isChecked())
     {
+        recordStep();
+
         double rsMin = ui->ledit_minValue->text().toDouble();
         double rsMax = ui->ledit_maxValue->text().toDouble();
 
@@ -1322,6 +1300,8 @@ void MainWindow::on_cbox_Lines_clicked(bool checked)
 // Clear Line Button
 void MainWindow::on_btn_clearLine_clicked()
 {
+    recordStep();
+
     for (QCPItemStraightLine *line: lines)
     {
         delete line;
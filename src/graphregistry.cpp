@@ -0,0 +1,114 @@
+/**
+ *@file graphregistry.cpp
+ *@brief Implementation of the registry that finds the graphs on the plot without scanning them
+ *
+ *This file contains the implementation of the registry of the graphs on the plot. Each graph is
+ *registered with its role (core, average, envelope or reference), its channel and, for a core
+ *graph, the slot of its core in the dataset. Lookups go through two hashes, one from the role,
+ *channel and slot to the graph and one from the graph back to them, so finding the average or
+ *the graph of a core costs the same with ten graphs or with thousands, and no graph names are
+ *compared.
+ *
+ *@note Graphs have to be registered when they are added and taken out before they are removed.
+ *
+ *@date[10/16/26]
+ */
+#include "graphregistry.h"
+
+void GraphRegistry::clear()
+{
+    graphs.clear();
+    entries.clear();
+    cores = 0;
+}
+
+// Role, channel and slot packed into one key, slot -1 for the graphs that are not cores
+quint64 GraphRegistry::key(GraphRole role, bool useLsData, int core)
+{
+    return (quint64(role) << 40) | (quint64(useLsData) << 32) | quint32(core);
+}
+
+// A graph already registered for the same role, channel and slot is replaced
+void GraphRegistry::add(QCPGraph *graph, GraphRole role, bool useLsData, int core)
+{
+    if (role != GraphRole::Core)
+    {
+        core = -1;
+    }
+
+    QCPGraph *previous = graphs.value(key(role, useLsData, core), nullptr);
+    if (previous)
+    {
+        entries.remove(previous);
+    }
+
+    graphs.insert(key(role, useLsData, core), graph);
+    entries.insert(graph, Entry{role, useLsData, core});
+
+    if (role == GraphRole::Core)
+    {
+        cores = qMax(cores, core + 1);
+    }
+}
+
+void GraphRegistry::remove(QCPGraph *graph)
+{
+    auto it = entries.find(graph);
+    if (it == entries.end())
+    {
+        return;
+    }
+
+    graphs.remove(key(it->role, it->useLsData, it->core));
+    entries.erase(it);
+}
+
+// Drop the core graphs of the removed slots (ascending) in both channels. The later slots move
+// down over the gaps in one pass, each by the number of removed slots before it.
+void GraphRegistry::removeCores(const QVector<int> &removed)
+{
+    if (removed.isEmpty())
+    {
+        return;
+    }
+
+    for (bool useLsData: {true, false})
+    {
+        int gaps = 0;
+        for (int i = removed.first(); i < cores; ++i)
+        {
+            if (gaps < removed.size() && removed[gaps] == i)
+            {
+                remove(graph(GraphRole::Core, useLsData, i));
+                ++gaps;
+                continue;
+            }
+
+            QCPGraph *moved = graphs.take(key(GraphRole::Core, useLsData, i));
+            if (moved)
+            {
+                graphs.insert(key(GraphRole::Core, useLsData, i - gaps), moved);
+                entries[moved].core = i - gaps;
+            }
+        }
+    }
+
+    cores = qMax(0, cores - int(removed.size()));
+}
+
+QCPGraph *GraphRegistry::graph(GraphRole role, bool useLsData, int core) const
+{
+    return graphs.value(key(role, useLsData, role == GraphRole::Core ? core : -1), nullptr);
+}
+
+CoreGraph *GraphRegistry::coreGraph(bool useLsData, int core) const
+{
+    return static_cast<CoreGraph*> (graph(GraphRole::Core, useLsData, core));
+}
+
+// Role of a graph, nullptr for a graph that is not registered
+const GraphRegistry::Entry *GraphRegistry::entry(const QCPGraph *graph) const
+{
+    auto it = entries.constFind(graph);
+    return it == entries.constEnd() ? nullptr : &it.value();
+}
@@ -0,0 +1,45 @@
+#ifndef GRAPHREGISTRY_H
+#define GRAPHREGISTRY_H
+
+#include <QHash>
+#include "coregraph.h"
+
+// What a graph on the plot shows
+enum class GraphRole
+{
+    Core,
+    Average,
+    Envelope,
+    Reference
+};
+
+// Graphs on the plot by role, channel and core, and the role of each graph, both hashed.
+// Core graphs are CoreGraph, core i of a channel is the graph registered for slot i.
+class GraphRegistry
+{
+public:
+    struct Entry
+    {
+        GraphRole role;
+        bool useLsData;
+        int core;	// Slot of a core graph, -1 for the others
+    };
+
+    void clear();
+    void add(QCPGraph *graph, GraphRole role, bool useLsData, int core = -1);
+    void remove(QCPGraph *graph);
+    void removeCores(const QVector<int> &removed);
+
+    QCPGraph *graph(GraphRole role, bool useLsData, int core = -1) const;
+    CoreGraph *coreGraph(bool useLsData, int core) const;
+    const Entry *entry(const QCPGraph *graph) const;
+
+private:
+    static quint64 key(GraphRole role, bool useLsData, int core);
+
+    QHash<quint64, QCPGraph*> graphs;
+    QHash<const QCPGraph*, Entry> entries;
+    int cores = 0;	// Core slots with graphs
+};
+
+#endif // GRAPHREGISTRY_H
@@ -0,0 +1,235 @@
+/**
+ *@file gzipdevice.cpp
+ *@brief Implementation of the gzip input device for compressed sweep files
+ *
+ *This file contains the implementation of a sequential QIODevice that reads .csv.gz files.
+ *The compressed file is inflated with zlib on a separate decoder thread into a small queue of
+ *blocks, while the CSV parser reads the inflated bytes on its own thread. Decompression and
+ *parsing therefore overlap, and at most a few blocks are held in memory at any time.
+ *
+ *@note The device is sequential, the data can only be read once from start to end.
+ *
+ *@date[10/16/26]
+ */
+#include "gzipdevice.h"
+#include <QThread>
+#include <QMutexLocker>
+#include <cstring>
+#if __has_include(<QtZlib/zlib.h>)
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+
+namespace
+{
+    const int compressedBlockSize = 256 * 1024;
+    const int inflatedBlockSize = 1024 * 1024;
+    const int maxQueuedBlocks = 4;
+}
+
+GzipDevice::GzipDevice(const QString &filePath):
+    file(filePath)
+{
+}
+
+GzipDevice::~GzipDevice()
+{
+    close();
+}
+
+// Open the compressed file and start inflating it
+bool GzipDevice::open(OpenMode mode)
+{
+    if ((mode & QIODevice::WriteOnly) || !file.open(QIODevice::ReadOnly))
+    {
+        setErrorString(file.errorString());
+        return false;
+    }
+
+    finished = false;
+    failed = false;
+    stopping = false;
+    blocks.clear();
+    current.clear();
+    currentOffset = 0;
+
+    decoder = QThread::create([this]()
+                              {
+                                  decode();
+                              });
+    decoder->start();
+
+    return QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+// Stop the decoder thread and release the file
+void GzipDevice::close()
+{
+    if (decoder != nullptr)
+    {
+        {
+            QMutexLocker locker(&mutex);
+            stopping = true;
+            slotFree.wakeAll();
+        }
+
+        decoder->wait();
+        delete decoder;
+        decoder = nullptr;
+    }
+
+    file.close();
+    blocks.clear();
+
+    if (isOpen())
+    {
+        QIODevice::close();
+    }
+}
+
+// Hand out inflated bytes, waits only while nothing has been copied yet
+qint64 GzipDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 copied = 0;
+    while (copied < maxSize)
+    {
+        if (currentOffset >= current.size())
+        {
+            QMutexLocker locker(&mutex);
+            while (blocks.isEmpty() && !finished && copied == 0)
+            {
+                blockReady.wait(&mutex);
+            }
+
+            if (blocks.isEmpty())
+            {
+                if (failed && copied == 0)
+                {
+                    setErrorString(decodeError);
+                    return -1;
+                }
+
+                break;
+            }
+
+            current = blocks.dequeue();
+            currentOffset = 0;
+            slotFree.wakeOne();
+        }
+
+        qint64 count = qMin(maxSize - copied, qint64(current.size()) - currentOffset);
+        std::memcpy(data + copied, current.constData() + currentOffset, count);
+        copied += count;
+        currentOffset += count;
+    }
+
+    return copied;
+}
+
+qint64 GzipDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+// Queue one inflated block, false when the device is being closed
+bool GzipDevice::pushBlock(const QByteArray &block)
+{
+    QMutexLocker locker(&mutex);
+    while (blocks.size() >= maxQueuedBlocks && !stopping)
+    {
+        slotFree.wait(&mutex);
+    }
+
+    if (stopping)
+    {
+        return false;
+    }
+
+    blocks.enqueue(block);
+    blockReady.wakeOne();
+    return true;
+}
+
+// Decoder thread: inflate the whole file, concatenated gzip members included
+void GzipDevice::decode()
+{
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+
+    // 15 + 32: gzip or zlib header, detected automatically
+    bool ok = inflateInit2(&stream, 15 + 32) == Z_OK;
+    bool streamEnded = false;
+    QString error = "Cannot initialize zlib";
+
+    QByteArray input(compressedBlockSize, Qt::Uninitialized);
+    QByteArray output(inflatedBlockSize, Qt::Uninitialized);
+
+    while (ok)
+    {
+        if (stream.avail_in == 0)
+        {
+            qint64 read = file.read(input.data(), input.size());
+            if (read < 0)
+            {
+                ok = false;
+                error = file.errorString();
+                break;
+            }
+
+            if (read == 0)
+            {
+                break;
+            }
+
+            stream.next_in = reinterpret_cast<Bytef*> (input.data());
+            stream.avail_in = uInt(read);
+        }
+
+        stream.next_out = reinterpret_cast<Bytef*> (output.data());
+        stream.avail_out = uInt(output.size());
+
+        int status = inflate(&stream, Z_NO_FLUSH);
+        if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+        {
+            ok = false;
+            error = QString("Corrupt gzip data: %1").arg(stream.msg ? stream.msg : "unknown error");
+            break;
+        }
+
+        streamEnded = status == Z_STREAM_END;
+        if (streamEnded && (stream.avail_in > 0 || !file.atEnd()))
+        {
+            // Another gzip member follows
+            inflateReset(&stream);
+        }
+
+        int produced = output.size() - int(stream.avail_out);
+        if (produced > 0)
+        {
+            output.truncate(produced);
+            if (!pushBlock(output))
+            {
+                break;
+            }
+
+            output = QByteArray(inflatedBlockSize, Qt::Uninitialized);
+        }
+    }
+
+    if (ok && !streamEnded)
+    {
+        ok = false;
+        error = "Truncated gzip file";
+    }
+
+    inflateEnd(&stream);
+
+    QMutexLocker locker(&mutex);
+    finished = true;
+    failed = !ok;
+    decodeError = error;
+    blockReady.wakeAll();
+}
@@ -0,0 +1,48 @@
+#ifndef GZIPDEVICE_H
+#define GZIPDEVICE_H
+
+#include <QIODevice>
+#include <QFile>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QThread;
+
+// Read-only device over a .gz file, inflated on its own thread while the reader consumes it
+class GzipDevice : public QIODevice
+{
+public:
+    explicit GzipDevice(const QString &filePath);
+    ~GzipDevice();
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    void decode();
+    bool pushBlock(const QByteArray &block);
+
+    QFile file;
+    QThread *decoder = nullptr;
+
+    // Inflated blocks waiting for the reader
+    QMutex mutex;
+    QWaitCondition blockReady;
+    QWaitCondition slotFree;
+    QQueue<QByteArray> blocks;
+    bool finished = false;
+    bool failed = false;
+    bool stopping = false;
+    QString decodeError;
+
+    QByteArray current;
+    qint64 currentOffset = 0;
+};
+
+#endif // GZIPDEVICE_H
@@ -1,10 +1,21 @@
 #include "mainwindow.h"
+#include "benchmark.h"
 
 #include <QApplication>
 #include  <QFile>
 
 int main(int argc, char *argv[])
 {
+    // Microbenchmarks instead of the GUI
+    for (int i = 1; i < argc; ++i)
+    {
+        if (QByteArray(argv[i]) == "--benchmark")
+        {
+            QTextStream out(stdout);
+            return runBenchmarks(out);
+        }
+    }
+
     QApplication a(argc, argv);
 
     MainWindow w;
@@ -32,6 +32,8 @@ MainWindow::MainWindow(QWidget *parent): QMainWindow(parent), ui(new Ui::MainWin
 
     // Setuping Plot
     setupPlot();
+    setupGridMenu();
+    setupHistoryMenu();
 
     // Double click
     connect(ui->Plot, &QCustomPlot::mouseDoubleClick, this, &MainWindow::onPlotDoubleClick);
@@ -54,6 +56,9 @@ MainWindow::MainWindow(QWidget *parent): QMainWindow(parent), ui(new Ui::MainWin
 
 MainWindow::~MainWindow()
 {
+    // Workers of a running load report back to this window, they have to be done before it goes
+    stopCsvLoad();
+
     closeDatabase();
     delete ui;
 }
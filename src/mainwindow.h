@@ -14,6 +14,15 @@
 #include <QAction>
 #include <QCursor>
 #include <QContextMenuEvent>
+#include <QFutureWatcher>
+#include <QProgressDialog>
+#include <QElapsedTimer>
+#include <QSemaphore>
+#include <QHash>
+#include "csvparser.h"
+#include "coredataset.h"
+#include "coregraph.h"
+#include "graphregistry.h"
 
 
 
@@ -21,6 +30,8 @@ QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
+struct CsvSource;	// A file or tar bundle member of a load, see csvFunctions.cpp
+
 // For Compare Table
 struct RecordedPoint
 {
@@ -38,35 +49,41 @@ struct RecordedPoint
     }
 };
 
-// For LS
-struct CSVInfo {
-    // For Ls
-    QColor color;
-    QString fileName;
-    QVector<double> frequencies;
-    QVector<double> lsValues;
-    QVector<double> rsValues;
-    QVector<double> frequenciesRs;
-    QVector<double> frequenciesLs;
-    QVector<double> values;
-    bool visible;
-    double averageLs;
-    double averageRs;
+// Per-frequency sums of the cores counted in an average, NaN points are not counted
+struct AverageSums
+{
+    QVector<double> sums;
+    QVector<int> counts;
+
+    void clear() { sums.clear(); counts.clear(); }
+    void add(const ColumnSpan &values);
+    void remove(const ColumnSpan &values);
+    QVector<double> average() const;
 };
-// For RS
-struct CSVInfo2 {
-    // For Rs
-    QColor color;
-    QString fileName;
-    QVector<double> frequencies;
-    QVector<double> lsValues;
-    QVector<double> rsValues;
-    QVector<double> frequenciesRs;
-    QVector<double> frequenciesLs;
-    QVector<double> values;
-    bool visible;
-    double averageLs;
-    double averageRs;
+
+// Level of one line of the Lines box, kept by value so a snapshot holds no plot item
+struct LineState
+{
+    double value;
+    QPen pen;
+
+    bool operator==(const LineState &other) const { return value == other.value && pen == other.pen; }
+};
+
+// Session state changed by the filtering steps. Every member is an implicitly shared Qt container,
+// so taking a snapshot copies no buffer and snapshots share whatever a step left unchanged.
+struct SessionSnapshot
+{
+    QVector<bool> visibleLs;
+    QVector<bool> visibleRs;
+    QVector<LineState> lines;
+    QList<RecordedPoint> recordedPoints;
+    QVector<double> distanceRatios;
+    AverageSums averageSumsLs;
+    AverageSums averageSumsRs;
+    bool avg = false;
+    bool averageShown = false;
+    bool averageUseLs = true;
 };
 
 
@@ -83,10 +100,27 @@ private:
     Ui::MainWindow *ui;
 
     // CSV's
-    QVector<CSVInfo> loadedCSV;
-    QVector<CSVInfo2> loadedCSVRS;
-    QVector<CSVInfo> loadedCSVLS;
-    QStringList fileNames;
+    CoreDataset dataset;	// Ls and Rs of every loaded core
+
+    // Parallel CSV loading
+    QFutureWatcher<void> *csvIndexWatcher = nullptr;	// Lists the members of tar bundles before parsing
+    QFutureWatcher<CsvParseResult> *csvLoadWatcher = nullptr;
+    QProgressDialog *csvLoadProgress = nullptr;
+    QVector<bool> csvLoaded;	// Which slots of the dataset are filled
+    BatchOrder csvLoadOrder;	// Parsed files wait here until they may be set
+    QVector<CsvDiagnostic> csvLoadDiagnostics;	// Quarantined rows and files of the last import
+    QElapsedTimer csvLoadTimer;
+    qint64 csvLoadBytes = 0;
+    int csvLoadCacheHits = 0;
+    QSharedPointer<QAtomicInt> csvLoadCancelled;	// Stops files that are streamed
+    QSharedPointer<QSemaphore> csvLoadChunkSlots;	// Streamed chunks the GUI thread has not taken yet
+    int csvLoadFirstSlot = 0;	// Slot of the batch's first file, > 0 when files are added
+    QHash<quint64, int> csvLoadHashes;	// Content hash -> slot of the core holding that sweep
+    int csvLoadDuplicates = 0;
+
+    // Frequency grid of the next session, picked in Settings -> Frequency Grid
+    GridOptions::Spacing gridSpacing = GridOptions::FirstCore;
+    GridOptions::Interpolation gridInterpolation = GridOptions::Linear;
 
     //Tracer
     QCPItemTracer* phaseTracer = nullptr;
@@ -98,13 +132,18 @@ private:
     QVector<QColor> graphColors;
 
     // RS-LS Graphs
-    QVector<double> averageLSValues;
-    QVector<double> averageRSValues;
-    QCPGraph *averageGraphLs = nullptr; // Average graph for Ls data
-    QCPGraph *averageGraphRs = nullptr; // Average graph for Rs data
+    AverageSums averageSumsLs;	// Sums of the visible cores once an average is calculated, kept up by setCoreVisible
+    AverageSums averageSumsRs;
+    GraphRegistry graphRegistry;	// Core graphs of both channels and the average, by role
     QAction* averageGraphActionLs;
     QAction* averageGraphActionRs;
 
+    // Undo/Redo of the filtering steps, the oldest steps are dropped past a limit
+    QVector<SessionSnapshot> undoSnapshots;
+    QVector<SessionSnapshot> redoSnapshots;
+    QAction *undoAction = nullptr;
+    QAction *redoAction = nullptr;
+
     // Right-click Menu
     QMenu* graphMenu;
     QCPGraph* selectedGraph = nullptr;
@@ -112,6 +151,8 @@ private:
 
     // Plot Setup
     void setupPlot();
+    void setupGridMenu();
+    void setupHistoryMenu();
 
     // Highlight Spinbox
     double thresholdRatio;
@@ -172,15 +213,49 @@ private:
     // Average Graph
     QVector<double> calculateAverageValues(bool useLsData, bool onlyVisibleGraphs);
     void addAverageGraph(const QVector<double>& averageValues, bool useLsData);
+    QCPGraph *averageGraph() const;
+    void updateAverageGraph();
+    void removeAverageGraphs();
+    void setCoreVisible(bool useLsData, int core, bool isVisible);
 
     // Converting
     QString convertLsValue(double rawValue);
     QString convertRsValue(double rawValue);
     QString convertFrequency(double rawFrequency);
 
+    // Graph Data
+    void setGraphData(QCPGraph *graph, const ColumnSpan &keys, const ColumnSpan &values);
+    void addCoreGraphs(int first);
+    void removeCoreGraphs(const QVector<int> &cores);
+    void showChannel(bool useLsData);
+    CoreGraph *coreGraph(bool useLsData, int core) const { return graphRegistry.coreGraph(useLsData, core); }
+
+    // CSV Loading
+    void loadCsvFiles(const QStringList &fileNames);
+    void parseCsvSources(QVector<CsvSource> sources);
+    void setCsvFile(int index);
+    bool hasCoreGrids() const;
+
+    // Streamed CSV Loading
+    void onCsvChunkParsed(int index, const CoreColumns &chunk);
+
+    // Import Report
+    void showImportReport();
+
+    // Session History
+    SessionSnapshot takeSnapshot() const;
+    void restoreSnapshot(const SessionSnapshot &snapshot);
+    void recordStep();
+    void clearHistory();
+    void updateHistoryActions();
+
 
     // Graphs
     void calculateDistanceRatios();
+    void calculateDistanceRatios(const QVector<double> &averageValues);
+    void rescaleToCores(bool useLsData);
+    void checkCoreSummaries(int first);
+    void skipDuplicateCore(const QString &filePath, int keptSlot);
 
     // Line Edit
     void updateLineEdits(QString fre, QString value);
@@ -207,6 +282,13 @@ private slots:
     void on_btn_save_plot_clicked();
     void on_btn_clear_plot_clicked();
     void on_btn_load_plot_clicked();
+    void on_btn_add_plot_clicked();
+    void onCsvFileParsed(int index);
+    void onCsvLoadFinished();
+    void cancelCsvLoad();
+    void stopCsvLoad();
+    void undoStep();
+    void redoStep();
     void on_btn_HighlightGraphs_clicked();
     void on_btn_avg_clicked();
     void on_btn_tablo_clicked();
@@ -0,0 +1,189 @@
+/**
+ *@file matrixstore.cpp
+ *@brief Implementation of the out-of-core store behind the core matrices
+ *
+ *This file contains the implementation of the storage of the channel matrices. A matrix stays on
+ *the heap while it is small. Once it grows past the heap limit, for studies that overlay a whole
+ *quarter of production, it is moved to a temporary file that is memory-mapped. The statistics
+ *then stream through the rows in order and the graphs touch only the rows of the cores they draw,
+ *so the OS keeps just the pages in use resident while the full population stays available. This
+ *bounds the sweep data only: the plot still holds a data-less core graph per core and channel,
+ *plus a legend item per shown core, so that part grows with the number of cores. The file grows
+ *by half its size at a time so loading cores one by one does not remap on every core. The
+ *rows of a streamed file go to a store that is file-backed from the start, they are written
+ *once while the file is parsed and read once when the core is set.
+ *
+ *@note Rows may move when the store grows, pointers into it are only valid until the next resize.
+ *
+ *@date[10/16/26]
+ */
+#include "matrixstore.h"
+#include <QDir>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    const qint64 heapLimitBytes = 256LL * 1024 * 1024;
+}
+
+MatrixStore::~MatrixStore()
+{
+    unmap();
+}
+
+void MatrixStore::clear()
+{
+    unmap();
+    file.reset();
+    heap.clear();
+    heap.squeeze();
+    count = 0;
+    capacity = 0;
+}
+
+// Grow or shrink to newCount doubles, the new ones set to value. A full temporary disk is
+// reported to the caller instead of thrown, the load stops and the session stays usable.
+bool MatrixStore::resize(qint64 newCount, double value)
+{
+    if (!mapped && newCount > 0 && (placement == FileOnly || newCount * qint64(sizeof(double)) > heapLimitBytes))
+    {
+        spill(newCount);
+    }
+
+    if (mapped)
+    {
+        if (newCount > capacity && !remap(newCount))
+        {
+            qDebug() << "Core store cannot grow to" << newCount << "values:" << file->errorString();
+            return false;
+        }
+    }
+    else
+    {
+        heap.resize(newCount);
+    }
+
+    qint64 oldCount = count;
+    count = newCount;
+    if (newCount > oldCount)
+    {
+        std::fill(data() + oldCount, data() + newCount, value);
+    }
+
+    return true;
+}
+
+bool MatrixStore::assign(qint64 newCount, double value)
+{
+    if (!resize(newCount, value))
+    {
+        return false;
+    }
+
+    std::fill(data(), data() + count, value);
+    return true;
+}
+
+// Add valueCount doubles at the end
+bool MatrixStore::append(const double *values, qint64 valueCount)
+{
+    qint64 oldCount = count;
+    if (!resize(count + valueCount, 0.0))
+    {
+        return false;
+    }
+
+    std::memcpy(data() + oldCount, values, sizeof(double) * valueCount);
+    return true;
+}
+
+// Drop every block of blockSize doubles whose keep flag is false, the kept ones move down in one pass
+void MatrixStore::removeBlocks(const QVector<bool> &keep, qint64 blockSize)
+{
+    double *values = data();
+    qint64 kept = 0;
+    for (qint64 block = 0; block < keep.size(); ++block)
+    {
+        if (!keep[block])
+        {
+            continue;
+        }
+
+        if (kept != block)
+        {
+            std::memmove(values + kept * blockSize, values + block * blockSize, sizeof(double) * blockSize);
+        }
+
+        ++kept;
+    }
+
+    count = kept * blockSize;
+    if (!mapped)
+    {
+        heap.resize(count);
+    }
+}
+
+// Move the heap contents into a mapped temporary file, the heap is kept if that fails
+bool MatrixStore::spill(qint64 minimumCount)
+{
+    file.reset(new QTemporaryFile(QDir::tempPath() + "/coredata_XXXXXX.bin"));
+    if (!file->open())
+    {
+        qDebug() << "Core store stays in memory, no temporary file:" << file->errorString();
+        file.reset();
+        return false;
+    }
+
+    capacity = 0;
+    if (!remap(minimumCount))
+    {
+        qDebug() << "Core store stays in memory, the file cannot be mapped:" << file->errorString();
+        file.reset();
+        return false;
+    }
+
+    std::memcpy(mapped, heap.constData(), sizeof(double) * count);
+    heap.clear();
+    heap.squeeze();
+    return true;
+}
+
+// Map a file holding at least minimumCount doubles, growing it by half its size at a time.
+// The file is unmapped first since it cannot be resized while mapped on every platform.
+bool MatrixStore::remap(qint64 minimumCount)
+{
+    qint64 oldCapacity = capacity;
+    qint64 newCapacity = qMax(minimumCount, capacity + capacity / 2);
+
+    unmap();
+    if (file->resize(newCapacity * qint64(sizeof(double))))
+    {
+        mapped = file->map(0, newCapacity * qint64(sizeof(double)));
+    }
+
+    if (mapped)
+    {
+        capacity = newCapacity;
+        return true;
+    }
+
+    // Keep what is stored, the contents are in the file
+    if (oldCapacity > 0)
+    {
+        mapped = file->map(0, oldCapacity * qint64(sizeof(double)));
+    }
+
+    return false;
+}
+
+void MatrixStore::unmap()
+{
+    if (mapped)
+    {
+        file->unmap(mapped);
+        mapped = nullptr;
+    }
+}
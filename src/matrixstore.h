@@ -0,0 +1,53 @@
+#ifndef MATRIXSTORE_H
+#define MATRIXSTORE_H
+
+#include <QVector>
+#include <QScopedPointer>
+#include <QTemporaryFile>
+
+// Growable array of doubles behind the matrices of a channel. Small ones live on the heap; past
+// a size limit the array moves to a memory-mapped temporary file, so the OS pages rows in as they
+// are read and out again under memory pressure, and the resident sweep data stays bounded however
+// many cores are loaded. Pointers into the store are valid until it is resized.
+class MatrixStore
+{
+public:
+    // Where the values start out, a FileOnly store is mapped from its first value on
+    enum Placement
+    {
+        HeapFirst,
+        FileOnly
+    };
+
+    explicit MatrixStore(Placement placement = HeapFirst): placement(placement) {}
+    ~MatrixStore();
+
+    qint64 size() const { return count; }
+    bool isMapped() const { return mapped != nullptr; }
+
+    const double *constData() const { return mapped ? reinterpret_cast<const double*> (mapped) : heap.constData(); }
+    double *data() { return mapped ? reinterpret_cast<double*> (mapped) : heap.data(); }
+
+    void clear();
+    // false when a mapped store cannot grow, the contents are then left as they were
+    bool resize(qint64 newCount, double value);
+    bool assign(qint64 newCount, double value);
+    bool append(const double *values, qint64 valueCount);
+    void removeBlocks(const QVector<bool> &keep, qint64 blockSize);
+
+private:
+    bool spill(qint64 minimumCount);
+    bool remap(qint64 minimumCount);
+    void unmap();
+
+    Placement placement;
+    QVector<double> heap;
+    QScopedPointer<QTemporaryFile> file;
+    uchar *mapped = nullptr;
+    qint64 count = 0;
+    qint64 capacity = 0;	// Doubles the mapped file holds
+
+    Q_DISABLE_COPY(MatrixStore)
+};
+
+#endif // MATRIXSTORE_H
@@ -0,0 +1,397 @@
+/**
+ *@file resampler.cpp
+ *@brief Implementation of the stage that aligns every core on the frequency grid of its channel
+ *
+ *This file contains the implementation of the resampling engine behind the dataset store. The
+ *grid of a channel is the sweep of its first core, the lowest slot of the first load with data in
+ *the channel, or a linear or log spaced grid over the frequency window. A core swept on other frequencies, from another station or with a dropped
+ *point, is resampled onto that grid by linear or natural cubic spline interpolation; points of
+ *the grid outside its sweep are NaN. The interpolation weights and the factored spline system
+ *depend only on the keys of a sweep, so they are computed once per distinct key set and reused
+ *for every core swept on it, leaving one branch-free loop per core. That loop gathers the two
+ *keys around each grid point and blends them 2 (SSE2) or 4 (AVX2) points per instruction, the
+ *path picked at runtime from the CPU features. Solving the spline system stays scalar, each row
+ *depends on the one before it, and it is one pass over the keys against the gathers over the grid.
+ *
+ *@note The weights are cached per key set, so a channel reuses one resampler for all of its cores.
+ *
+ *@date[10/16/26]
+ */
+#include "resampler.h"
+#include <QtNumeric>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RESAMPLER_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Points [begin, points) of the grid, each blended from its left and right key
+    void linearScalar(const double *source, const int *left, const int *right, const double *weight,
+                      int begin, int points, double *output)
+    {
+        for (int i = begin; i < points; ++i)
+        {
+            double low = source[left[i]];
+            double high = source[right[i]];
+            output[i] = low + weight[i] * (high - low);
+        }
+    }
+
+    // A spline segment always has a key on its right, the terms are summed in the same order on every path
+    void splineScalar(const double *source, const double *curvature, const int *left, const double *weight,
+                      const double *lowCurve, const double *highCurve, int begin, int points, double *output)
+    {
+        for (int i = begin; i < points; ++i)
+        {
+            int low = left[i];
+            output[i] = (1.0 - weight[i]) * source[low] + weight[i] * source[low + 1] +
+                        lowCurve[i] * curvature[low] + highCurve[i] * curvature[low + 1];
+        }
+    }
+
+#ifdef RESAMPLER_X86
+    // SSE2 has no gather, the two points of a register are loaded into its halves
+
+    __attribute__((target("sse2"))) inline __m128d gatherSse2(const double *source, int first, int second)
+    {
+        return _mm_loadh_pd(_mm_load_sd(source + first), source + second);
+    }
+
+    __attribute__((target("sse2"))) void linearSse2(const double *source, const int *left, const int *right, const double *weight,
+                                                    int points, double *output)
+    {
+        int i = 0;
+        for (; i + 2 <= points; i += 2)
+        {
+            __m128d low = gatherSse2(source, left[i], left[i + 1]);
+            __m128d high = gatherSse2(source, right[i], right[i + 1]);
+            __m128d share = _mm_loadu_pd(weight + i);
+            _mm_storeu_pd(output + i, _mm_add_pd(low, _mm_mul_pd(share, _mm_sub_pd(high, low))));
+        }
+
+        linearScalar(source, left, right, weight, i, points, output);
+    }
+
+    __attribute__((target("sse2"))) void splineSse2(const double *source, const double *curvature, const int *left, const double *weight,
+                                                    const double *lowCurve, const double *highCurve, int points, double *output)
+    {
+        const __m128d ones = _mm_set1_pd(1.0);
+
+        int i = 0;
+        for (; i + 2 <= points; i += 2)
+        {
+            __m128d share = _mm_loadu_pd(weight + i);
+            __m128d blend = _mm_add_pd(_mm_mul_pd(_mm_sub_pd(ones, share), gatherSse2(source, left[i], left[i + 1])),
+                                       _mm_mul_pd(share, gatherSse2(source, left[i] + 1, left[i + 1] + 1)));
+            blend = _mm_add_pd(blend, _mm_mul_pd(_mm_loadu_pd(lowCurve + i), gatherSse2(curvature, left[i], left[i + 1])));
+            blend = _mm_add_pd(blend, _mm_mul_pd(_mm_loadu_pd(highCurve + i), gatherSse2(curvature, left[i] + 1, left[i + 1] + 1)));
+            _mm_storeu_pd(output + i, blend);
+        }
+
+        splineScalar(source, curvature, left, weight, lowCurve, highCurve, i, points, output);
+    }
+
+    // The masked gather with a zero source, the plain one trips -Wmaybe-uninitialized in the GCC headers
+    __attribute__((target("avx2"))) inline __m256d gatherAvx2(const double *source, __m128i keys)
+    {
+        return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), source, keys, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+    }
+
+    __attribute__((target("avx2"))) void linearAvx2(const double *source, const int *left, const int *right, const double *weight,
+                                                    int points, double *output)
+    {
+        int i = 0;
+        for (; i + 4 <= points; i += 4)
+        {
+            __m128i lowKeys = _mm_loadu_si128(reinterpret_cast<const __m128i*> (left + i));
+            __m128i highKeys = _mm_loadu_si128(reinterpret_cast<const __m128i*> (right + i));
+            __m256d low = gatherAvx2(source, lowKeys);
+            __m256d high = gatherAvx2(source, highKeys);
+            __m256d share = _mm256_loadu_pd(weight + i);
+            _mm256_storeu_pd(output + i, _mm256_add_pd(low, _mm256_mul_pd(share, _mm256_sub_pd(high, low))));
+        }
+
+        linearScalar(source, left, right, weight, i, points, output);
+    }
+
+    __attribute__((target("avx2"))) void splineAvx2(const double *source, const double *curvature, const int *left, const double *weight,
+                                                    const double *lowCurve, const double *highCurve, int points, double *output)
+    {
+        const __m256d ones = _mm256_set1_pd(1.0);
+        const __m128i next = _mm_set1_epi32(1);
+
+        int i = 0;
+        for (; i + 4 <= points; i += 4)
+        {
+            __m128i lowKeys = _mm_loadu_si128(reinterpret_cast<const __m128i*> (left + i));
+            __m128i highKeys = _mm_add_epi32(lowKeys, next);
+            __m256d share = _mm256_loadu_pd(weight + i);
+            __m256d blend = _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(ones, share), gatherAvx2(source, lowKeys)),
+                                          _mm256_mul_pd(share, gatherAvx2(source, highKeys)));
+            blend = _mm256_add_pd(blend, _mm256_mul_pd(_mm256_loadu_pd(lowCurve + i), gatherAvx2(curvature, lowKeys)));
+            blend = _mm256_add_pd(blend, _mm256_mul_pd(_mm256_loadu_pd(highCurve + i), gatherAvx2(curvature, highKeys)));
+            _mm256_storeu_pd(output + i, blend);
+        }
+
+        splineScalar(source, curvature, left, weight, lowCurve, highCurve, i, points, output);
+    }
+#endif
+}
+
+QVector<double> GridOptions::makeGrid(const ColumnSpan &firstKeys) const
+{
+    if (spacing == FirstCore || firstKeys.isEmpty())
+    {
+        return QVector<double> (firstKeys.begin(), firstKeys.end());
+    }
+
+    double lower = minFrequency;
+    double upper = maxFrequency;
+    if (lower >= upper)
+    {
+        lower = firstKeys[0];
+        upper = firstKeys[firstKeys.size() - 1];
+    }
+
+    int count = points > 0 ? points : firstKeys.size();
+    QVector<double> grid(count, lower);
+    if (count < 2)
+    {
+        return grid;
+    }
+
+    // Log spacing needs positive frequencies, a window reaching 0 is spaced linearly
+    bool logSpacing = spacing == LogSpacing && lower > 0.0;
+    double start = logSpacing ? std::log(lower) : lower;
+    double step = ((logSpacing ? std::log(upper) : upper) - start) / (count - 1);
+    for (int i = 0; i < count; ++i)
+    {
+        double position = start + step * i;
+        grid[i] = logSpacing ? std::exp(position) : position;
+    }
+
+    grid[count - 1] = upper;
+    return grid;
+}
+
+ResamplePlan::ResamplePlan(const ColumnSpan &keys, const QVector<double> &grid, GridOptions::Interpolation interpolation):
+    sourceKeys(keys.begin(), keys.end()),
+    gridSize(grid.size())
+{
+    int count = keys.size();
+    identity = count == gridSize && std::equal(keys.begin(), keys.end(), grid.constBegin());
+    if (identity || count == 0)
+    {
+        return;
+    }
+
+    // Grid points within the sweep, both are sorted
+    inside = std::lower_bound(grid.constBegin(), grid.constEnd(), keys[0]) - grid.constBegin();
+    insideEnd = std::upper_bound(grid.constBegin(), grid.constEnd(), keys[count - 1]) - grid.constBegin();
+    insideEnd = qMax(inside, insideEnd);
+
+    int points = insideEnd - inside;
+    segment.resize(points);
+    nextSegment.resize(points);
+    rightWeight.resize(points);
+
+    int left = 0;
+    for (int i = 0; i < points; ++i)
+    {
+        double frequency = grid[inside + i];
+
+        // The segment only moves forward
+        while (left + 2 < count && keys[left + 1] < frequency)
+        {
+            ++left;
+        }
+
+        int right = qMin(left + 1, count - 1);
+        double span = keys[right] - keys[left];
+        segment[i] = left;
+        nextSegment[i] = right;
+        rightWeight[i] = (span <= 0.0 || frequency <= keys[left]) ? 0.0 : qMin(1.0, (frequency - keys[left]) / span);
+    }
+
+    // A spline needs three keys and strictly rising ones, otherwise linear is used
+    keyStep.resize(qMax(0, count - 1));
+    bool rising = true;
+    for (int j = 0; j + 1 < count; ++j)
+    {
+        keyStep[j] = keys[j + 1] - keys[j];
+        rising = rising && keyStep[j] > 0.0;
+    }
+
+    spline = interpolation == GridOptions::Spline && count >= 3 && rising;
+    if (!spline)
+    {
+        keyStep.clear();
+        return;
+    }
+
+    leftCurve.resize(points);
+    rightCurve.resize(points);
+    for (int i = 0; i < points; ++i)
+    {
+        double h = keyStep[qMin(segment[i], count - 2)];
+        double b = rightWeight[i];
+        double a = 1.0 - b;
+        leftCurve[i] = (a * a * a - a) * h * h / 6.0;
+        rightCurve[i] = (b * b * b - b) * h * h / 6.0;
+    }
+
+    // Rows 1 .. count - 2 of h[j-1]/6 M[j-1] + (h[j-1] + h[j])/3 M[j] + h[j]/6 M[j+1] = slope change
+    subDiagonal.fill(0.0, count);
+    reducedUpper.fill(0.0, count);
+    inversePivot.fill(0.0, count);
+    for (int j = 1; j < count - 1; ++j)
+    {
+        subDiagonal[j] = keyStep[j - 1] / 6.0;
+        double pivot = (keyStep[j - 1] + keyStep[j]) / 3.0 - subDiagonal[j] * reducedUpper[j - 1];
+        inversePivot[j] = 1.0 / pivot;
+        reducedUpper[j] = keyStep[j] / 6.0 * inversePivot[j];
+    }
+}
+
+// Widest path this CPU can run
+ResamplePlan::Path ResamplePlan::bestPath()
+{
+    static const Path path = isSupported(Avx2) ? Avx2 : isSupported(Sse2) ? Sse2 : Scalar;
+    return path;
+}
+
+bool ResamplePlan::isSupported(Path path)
+{
+    switch (path)
+    {
+        case Scalar:
+            return true;
+#ifdef RESAMPLER_X86
+        case Sse2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case Avx2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+const char *ResamplePlan::pathName(Path path)
+{
+    switch (path)
+    {
+        case Sse2:
+            return "SSE2";
+        case Avx2:
+            return "AVX2";
+        default:
+            return "Scalar";
+    }
+}
+
+bool ResamplePlan::matches(const ColumnSpan &keys) const
+{
+    return keys.size() == sourceKeys.size() && std::equal(keys.begin(), keys.end(), sourceKeys.constBegin());
+}
+
+// Second derivatives of the natural spline through values, 0 at both ends
+void ResamplePlan::solveSecondDerivatives(const ColumnSpan &values, double *secondDerivatives) const
+{
+    int count = values.size();
+    secondDerivatives[0] = 0.0;
+    secondDerivatives[count - 1] = 0.0;
+
+    // Forward sweep, the factors come from the plan
+    double previous = 0.0;
+    for (int j = 1; j < count - 1; ++j)
+    {
+        double slopeChange = (values[j + 1] - values[j]) / keyStep[j] - (values[j] - values[j - 1]) / keyStep[j - 1];
+        previous = (slopeChange - subDiagonal[j] * previous) * inversePivot[j];
+        secondDerivatives[j] = previous;
+    }
+
+    for (int j = count - 3; j >= 1; --j)
+    {
+        secondDerivatives[j] -= reducedUpper[j] * secondDerivatives[j + 1];
+    }
+}
+
+// The path has to be supported by the CPU, the resampler checks it once
+void ResamplePlan::apply(const ColumnSpan &values, double *target, Path path) const
+{
+    if (identity)
+    {
+        std::memcpy(target, values.data, sizeof(double) * gridSize);
+        return;
+    }
+
+    std::fill(target, target + inside, qQNaN());
+    std::fill(target + insideEnd, target + gridSize, qQNaN());
+
+    int points = insideEnd - inside;
+    const int *left = segment.constData();
+    const double *weight = rightWeight.constData();
+    const double *source = values.data;
+    double *output = target + inside;
+
+    if (!spline)
+    {
+        const int *right = nextSegment.constData();
+        switch (path)
+        {
+#ifdef RESAMPLER_X86
+            case Sse2:
+                return linearSse2(source, left, right, weight, points, output);
+            case Avx2:
+                return linearAvx2(source, left, right, weight, points, output);
+#endif
+            default:
+                return linearScalar(source, left, right, weight, 0, points, output);
+        }
+    }
+
+    QVector<double> secondDerivatives(values.size());
+    solveSecondDerivatives(values, secondDerivatives.data());
+    const double *curvature = secondDerivatives.constData();
+    const double *lowCurve = leftCurve.constData();
+    const double *highCurve = rightCurve.constData();
+    switch (path)
+    {
+#ifdef RESAMPLER_X86
+        case Sse2:
+            return splineSse2(source, curvature, left, weight, lowCurve, highCurve, points, output);
+        case Avx2:
+            return splineAvx2(source, curvature, left, weight, lowCurve, highCurve, points, output);
+#endif
+        default:
+            return splineScalar(source, curvature, left, weight, lowCurve, highCurve, 0, points, output);
+    }
+}
+
+Resampler::Resampler(ResamplePlan::Path path):
+    planPath(ResamplePlan::isSupported(path) ? path : ResamplePlan::Scalar)
+{
+}
+
+// Resample values at keys onto grid, the plan of these keys is built the first time they are seen
+void Resampler::resample(const ColumnSpan &keys, const ColumnSpan &values, const QVector<double> &grid,
+                         GridOptions::Interpolation interpolation, double *target)
+{
+    quint64 hash = qHashBits(keys.data, sizeof(double) * keys.size(), uint(interpolation));
+    QSharedPointer<ResamplePlan> plan = plans.value(hash);
+    if (plan.isNull() || !plan->matches(keys))
+    {
+        plan = QSharedPointer<ResamplePlan>::create(keys, grid, interpolation);
+        plans.insert(hash, plan);
+    }
+
+    plan->apply(values, target, planPath);
+}
@@ -0,0 +1,89 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QVector>
+#include <QHash>
+#include <QSharedPointer>
+#include "csvparser.h"
+
+// Shared frequency grid of a channel and how cores are resampled onto it. The first core is the
+// one in the lowest slot of the session's first load that has data in the channel, whichever file
+// of that load finishes parsing first; it fixes the grid, and for a spaced grid its range and points.
+struct GridOptions
+{
+    enum Spacing { FirstCore, LinearSpacing, LogSpacing };
+    enum Interpolation { Linear, Spline };
+
+    Spacing spacing = FirstCore;
+    Interpolation interpolation = Linear;
+    double minFrequency = 0.0;	// Range of a spaced grid, the first core's range when not set
+    double maxFrequency = 0.0;
+    int points = 0;	// Points of a spaced grid, as many as the first core has when 0
+
+    QVector<double> makeGrid(const ColumnSpan &firstKeys) const;
+};
+
+// Weights that take a core sampled at keys onto a grid. They depend on the keys only, so all
+// cores swept on the same keys share one plan and applying it is a straight loop per core, run
+// with the widest vector instructions the CPU supports.
+class ResamplePlan
+{
+public:
+    enum Path
+    {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    ResamplePlan(const ColumnSpan &keys, const QVector<double> &grid, GridOptions::Interpolation interpolation);
+
+    static Path bestPath();
+    static bool isSupported(Path path);
+    static const char *pathName(Path path);
+
+    bool matches(const ColumnSpan &keys) const;
+    void apply(const ColumnSpan &values, double *target, Path path) const;
+
+private:
+    void solveSecondDerivatives(const ColumnSpan &values, double *secondDerivatives) const;
+
+    QVector<double> sourceKeys;
+    int gridSize = 0;
+    bool identity = false;	// Keys are the grid, values are copied
+    bool spline = false;
+
+    // Grid points [inside, insideEnd) lie within the keys, the rest are NaN
+    int inside = 0;
+    int insideEnd = 0;
+    QVector<int> segment;	// Left key of each inside grid point
+    QVector<int> nextSegment;	// Right key, the left one again for a single key
+    QVector<double> rightWeight;	// Share of the right key, the left one gets 1 - rightWeight
+    QVector<double> leftCurve;	// Spline terms (A^3 - A) h^2 / 6 and (B^3 - B) h^2 / 6
+    QVector<double> rightCurve;
+
+    // Natural spline system over the keys, factored once for the Thomas algorithm
+    QVector<double> keyStep;	// h = keys[j + 1] - keys[j]
+    QVector<double> subDiagonal;
+    QVector<double> reducedUpper;
+    QVector<double> inversePivot;
+};
+
+// Plans of the key sets seen so far, looked up by a hash of the keys
+class Resampler
+{
+public:
+    explicit Resampler(ResamplePlan::Path path = ResamplePlan::bestPath());
+
+    ResamplePlan::Path path() const { return planPath; }
+
+    void clear() { plans.clear(); }
+    void resample(const ColumnSpan &keys, const ColumnSpan &values, const QVector<double> &grid,
+                  GridOptions::Interpolation interpolation, double *target);
+
+private:
+    QHash<quint64, QSharedPointer<ResamplePlan>> plans;
+    ResamplePlan::Path planPath;
+};
+
+#endif // RESAMPLER_H
@@ -0,0 +1,198 @@
+/**
+ *@file sessionhistory.cpp
+ *@brief Implementation of the undo/redo history of the filtering steps
+ *
+ *This file contains the implementation of the session history behind Edit -> Undo and Redo.
+ *Before a step hides graphs, runs Highlight, changes the lines, the recorded points or the
+ *average, the state it changes is taken as a snapshot. A snapshot is a set of implicitly shared
+ *Qt containers, so taking one copies no data; a buffer is only copied when the session next
+ *writes to it, and snapshots keep sharing every buffer the steps between them left alone.
+ *Stepping back restores the containers and rebuilds the plot from them without reloading.
+ *
+ *@note This file should be included along with the MainWindow class implementation to ensure
+ *proper functioning of the undo and redo history in the data visualization application.
+ *
+ *@date[10/16/26]
+ */
+#include "mainwindow.h"
+#include "ui_mainwindow.h"
+#include <QDebug>
+
+namespace
+{
+    const int maxUndoSteps = 100;
+}
+
+// Edit -> Undo/Redo
+void MainWindow::setupHistoryMenu()
+{
+    QMenu *editMenu = new QMenu("Edit", ui->menuBar);
+    ui->menuBar->insertMenu(ui->menuSettings->menuAction(), editMenu);
+
+    undoAction = editMenu->addAction("Undo");
+    undoAction->setShortcut(QKeySequence::Undo);
+    connect(undoAction, &QAction::triggered, this, &MainWindow::undoStep);
+
+    redoAction = editMenu->addAction("Redo");
+    redoAction->setShortcut(QKeySequence::Redo);
+    connect(redoAction, &QAction::triggered, this, &MainWindow::redoStep);
+
+    updateHistoryActions();
+}
+
+// The current session state, sharing the buffers of the session and of the last snapshot
+SessionSnapshot MainWindow::takeSnapshot() const
+{
+    SessionSnapshot snapshot;
+    snapshot.visibleLs = dataset.channel(true).visibility();
+    snapshot.visibleRs = dataset.channel(false).visibility();
+    snapshot.recordedPoints = recordedPoints;
+    snapshot.distanceRatios = distanceRatios;
+    snapshot.averageSumsLs = averageSumsLs;
+    snapshot.averageSumsRs = averageSumsRs;
+    snapshot.avg = avg;
+
+    QCPGraph *graph = averageGraph();
+    snapshot.averageShown = graph != nullptr;
+    snapshot.averageUseLs = graph == nullptr || graphRegistry.entry(graph)->useLsData;
+
+    // Lines live on the plot as items, unchanged lines reuse the last snapshot's buffer
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        snapshot.lines.append({lines[i]->point1->coords().y(), lines[i]->pen()});
+    }
+
+    if (!undoSnapshots.isEmpty() && undoSnapshots.last().lines == snapshot.lines)
+    {
+        snapshot.lines = undoSnapshots.last().lines;
+    }
+
+    return snapshot;
+}
+
+// Put the session back into a snapshot's state, cores loaded after it was taken are shown
+void MainWindow::restoreSnapshot(const SessionSnapshot &snapshot)
+{
+    for (bool useLsData: {true, false})
+    {
+        ChannelMatrix &matrix = dataset.channel(useLsData);
+        QVector<bool> visibility = useLsData ? snapshot.visibleLs : snapshot.visibleRs;
+        AverageSums &sums = useLsData ? averageSumsLs : averageSumsRs;
+        sums = useLsData ? snapshot.averageSumsLs : snapshot.averageSumsRs;
+        while (visibility.size() < matrix.coreCount())
+        {
+            // The running sums of an average follow the cores shown since
+            if (snapshot.avg)
+            {
+                sums.add(matrix.core(visibility.size()));
+            }
+
+            visibility.append(true);
+        }
+
+        matrix.setVisibility(visibility);
+    }
+
+    recordedPoints = snapshot.recordedPoints;
+    distanceRatios = snapshot.distanceRatios;
+    avg = snapshot.avg;
+
+    // Graphs and legend of the shown channel, this also takes the average off
+    bool useLsData = ui->radioButton_Ls->isChecked();
+    showChannel(useLsData);
+
+    // The average comes back only on the channel it was calculated for
+    if (snapshot.averageShown && snapshot.averageUseLs == useLsData)
+    {
+        QVector<double> averageValues = (useLsData ? averageSumsLs : averageSumsRs).average();
+        addAverageGraph(averageValues, useLsData);
+
+        // Ratios of fewer cores than are loaded now are taken again against the restored average
+        if (distanceRatios.size() != dataset.coreCount())
+        {
+            calculateDistanceRatios(averageValues);
+        }
+    }
+
+    for (QCPItemStraightLine *line: lines)
+    {
+        delete line;
+    }
+
+    lines.clear();
+    for (const LineState &state: snapshot.lines)
+    {
+        QCPItemStraightLine *line = new QCPItemStraightLine(ui->Plot);
+        line->point1->setCoords(0, state.value);
+        line->point2->setCoords(1, state.value);
+        line->setPen(state.pen);
+        line->setVisible(ui->cbox_Lines->isChecked());
+        lines.append(line);
+    }
+
+    ui->Plot->replot();
+}
+
+// Called before a step changes the session, the step can then be undone
+void MainWindow::recordStep()
+{
+    undoSnapshots.append(takeSnapshot());
+    if (undoSnapshots.size() > maxUndoSteps)
+    {
+        undoSnapshots.removeFirst();
+    }
+
+    redoSnapshots.clear();
+    updateHistoryActions();
+}
+
+void MainWindow::clearHistory()
+{
+    undoSnapshots.clear();
+    redoSnapshots.clear();
+    updateHistoryActions();
+}
+
+void MainWindow::updateHistoryActions()
+{
+    if (undoAction)
+    {
+        undoAction->setEnabled(!undoSnapshots.isEmpty());
+    }
+
+    if (redoAction)
+    {
+        redoAction->setEnabled(!redoSnapshots.isEmpty());
+    }
+}
+
+// Edit -> Undo
+void MainWindow::undoStep()
+{
+    // The slots of a running load are not settled yet
+    if (undoSnapshots.isEmpty() || csvIndexWatcher || csvLoadWatcher)
+    {
+        return;
+    }
+
+    redoSnapshots.append(takeSnapshot());
+    restoreSnapshot(undoSnapshots.takeLast());
+    updateHistoryActions();
+
+    qDebug() << "Undo," << undoSnapshots.size() << "steps left";
+}
+
+// Edit -> Redo
+void MainWindow::redoStep()
+{
+    if (redoSnapshots.isEmpty() || csvIndexWatcher || csvLoadWatcher)
+    {
+        return;
+    }
+
+    undoSnapshots.append(takeSnapshot());
+    restoreSnapshot(redoSnapshots.takeLast());
+    updateHistoryActions();
+
+    qDebug() << "Redo," << redoSnapshots.size() << "steps left";
+}
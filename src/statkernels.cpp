@@ -0,0 +1,345 @@
+/**
+ *@file statkernels.cpp
+ *@brief Implementation of the vectorized kernels behind the averages and distance ratios
+ *
+ *This file contains the implementation of the loops that sum cores into an average, take them
+ *out again, divide the sums into the average and measure the distance of a core to it. A core
+ *row of the channel matrix is contiguous, so the loops run 2 (SSE2) or 4 (AVX2) frequencies per
+ *instruction; NaN points are masked out with a compare instead of a branch per point. The path
+ *is picked at runtime from the CPU features, and a scalar loop is used everywhere else.
+ *
+ *@note Every kernel path has to give the results of the scalar loop, which is the reference.
+ *
+ *@date[10/16/26]
+ */
+#include "statkernels.h"
+#include <QtNumeric>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STATKERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    void accumulateScalar(const double *values, int begin, int size, double *sums, int *counts)
+    {
+        for (int i = begin; i < size; ++i)
+        {
+            bool valid = !qIsNaN(values[i]);
+            sums[i] += valid ? values[i] : 0.0;
+            counts[i] += valid;
+        }
+    }
+
+    void subtractScalar(const double *values, int begin, int size, double *sums, int *counts)
+    {
+        for (int i = begin; i < size; ++i)
+        {
+            if (qIsNaN(values[i]))
+            {
+                continue;
+            }
+
+            --counts[i];
+            sums[i] = counts[i] > 0 ? sums[i] - values[i] : 0.0;
+        }
+    }
+
+    void meanScalar(const double *sums, const int *counts, int begin, int size, double *averages)
+    {
+        for (int i = begin; i < size; ++i)
+        {
+            averages[i] = counts[i] > 0 ? sums[i] / counts[i] : qQNaN();
+        }
+    }
+
+    double absoluteDifferenceScalar(const double *values, const double *reference, int begin, int size, int *points)
+    {
+        double total = 0.0;
+        for (int i = begin; i < size; ++i)
+        {
+            double difference = std::abs(values[i] - reference[i]);
+            if (!qIsNaN(difference))
+            {
+                total += difference;
+                ++*points;
+            }
+        }
+
+        return total;
+    }
+
+#ifdef STATKERNELS_X86
+    // The ordered compare is all ones where a point is not NaN, as int32 lanes it is -1 per counted point
+
+    __attribute__((target("sse2"))) void accumulateSse2(const double *values, int size, double *sums, int *counts)
+    {
+        int i = 0;
+        for (; i + 2 <= size; i += 2)
+        {
+            __m128d point = _mm_loadu_pd(values + i);
+            __m128d valid = _mm_cmpord_pd(point, point);
+            _mm_storeu_pd(sums + i, _mm_add_pd(_mm_loadu_pd(sums + i), _mm_and_pd(valid, point)));
+
+            __m128i counted = _mm_shuffle_epi32(_mm_castpd_si128(valid), _MM_SHUFFLE(2, 0, 2, 0));
+            __m128i count = _mm_loadl_epi64(reinterpret_cast<const __m128i*> (counts + i));
+            _mm_storel_epi64(reinterpret_cast<__m128i*> (counts + i), _mm_sub_epi32(count, counted));
+        }
+
+        accumulateScalar(values, i, size, sums, counts);
+    }
+
+    __attribute__((target("sse2"))) void subtractSse2(const double *values, int size, double *sums, int *counts)
+    {
+        int i = 0;
+        for (; i + 2 <= size; i += 2)
+        {
+            __m128d point = _mm_loadu_pd(values + i);
+            __m128d valid = _mm_cmpord_pd(point, point);
+
+            __m128i counted = _mm_shuffle_epi32(_mm_castpd_si128(valid), _MM_SHUFFLE(2, 0, 2, 0));
+            __m128i count = _mm_add_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*> (counts + i)), counted);
+            _mm_storel_epi64(reinterpret_cast<__m128i*> (counts + i), count);
+
+            __m128d emptied = _mm_and_pd(valid, _mm_cmple_pd(_mm_cvtepi32_pd(count), _mm_setzero_pd()));
+            __m128d sum = _mm_sub_pd(_mm_loadu_pd(sums + i), _mm_and_pd(valid, point));
+            _mm_storeu_pd(sums + i, _mm_andnot_pd(emptied, sum));
+        }
+
+        subtractScalar(values, i, size, sums, counts);
+    }
+
+    __attribute__((target("sse2"))) void meanSse2(const double *sums, const int *counts, int size, double *averages)
+    {
+        const __m128d nan = _mm_set1_pd(qQNaN());
+
+        int i = 0;
+        for (; i + 2 <= size; i += 2)
+        {
+            __m128d count = _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i*> (counts + i)));
+            __m128d average = _mm_div_pd(_mm_loadu_pd(sums + i), count);
+            __m128d empty = _mm_cmple_pd(count, _mm_setzero_pd());
+            _mm_storeu_pd(averages + i, _mm_or_pd(_mm_and_pd(empty, nan), _mm_andnot_pd(empty, average)));
+        }
+
+        meanScalar(sums, counts, i, size, averages);
+    }
+
+    __attribute__((target("sse2"))) double absoluteDifferenceSse2(const double *values, const double *reference, int size, int *points)
+    {
+        const __m128d signBits = _mm_set1_pd(-0.0);
+        const __m128d ones = _mm_set1_pd(1.0);
+        __m128d total = _mm_setzero_pd();
+        __m128d counted = _mm_setzero_pd();
+
+        int i = 0;
+        for (; i + 2 <= size; i += 2)
+        {
+            __m128d difference = _mm_sub_pd(_mm_loadu_pd(values + i), _mm_loadu_pd(reference + i));
+            __m128d valid = _mm_cmpord_pd(difference, difference);
+            total = _mm_add_pd(total, _mm_and_pd(valid, _mm_andnot_pd(signBits, difference)));
+            counted = _mm_add_pd(counted, _mm_and_pd(valid, ones));
+        }
+
+        double lanes[2];
+        _mm_storeu_pd(lanes, counted);
+        *points += int(lanes[0] + lanes[1]);
+        _mm_storeu_pd(lanes, total);
+
+        return lanes[0] + lanes[1] + absoluteDifferenceScalar(values, reference, i, size, points);
+    }
+
+    // Low int32 of each 64-bit lane, gathered into the lower 128 bits
+    __attribute__((target("avx2"))) inline __m128i countLanes(__m256d mask)
+    {
+        const __m256i lowDwords = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+        return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(mask), lowDwords));
+    }
+
+    __attribute__((target("avx2"))) void accumulateAvx2(const double *values, int size, double *sums, int *counts)
+    {
+        int i = 0;
+        for (; i + 4 <= size; i += 4)
+        {
+            __m256d point = _mm256_loadu_pd(values + i);
+            __m256d valid = _mm256_cmp_pd(point, point, _CMP_ORD_Q);
+            _mm256_storeu_pd(sums + i, _mm256_add_pd(_mm256_loadu_pd(sums + i), _mm256_and_pd(valid, point)));
+
+            __m128i count = _mm_loadu_si128(reinterpret_cast<const __m128i*> (counts + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*> (counts + i), _mm_sub_epi32(count, countLanes(valid)));
+        }
+
+        accumulateScalar(values, i, size, sums, counts);
+    }
+
+    __attribute__((target("avx2"))) void subtractAvx2(const double *values, int size, double *sums, int *counts)
+    {
+        int i = 0;
+        for (; i + 4 <= size; i += 4)
+        {
+            __m256d point = _mm256_loadu_pd(values + i);
+            __m256d valid = _mm256_cmp_pd(point, point, _CMP_ORD_Q);
+
+            __m128i count = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*> (counts + i)), countLanes(valid));
+            _mm_storeu_si128(reinterpret_cast<__m128i*> (counts + i), count);
+
+            __m256d emptied = _mm256_and_pd(valid, _mm256_cmp_pd(_mm256_cvtepi32_pd(count), _mm256_setzero_pd(), _CMP_LE_OQ));
+            __m256d sum = _mm256_sub_pd(_mm256_loadu_pd(sums + i), _mm256_and_pd(valid, point));
+            _mm256_storeu_pd(sums + i, _mm256_andnot_pd(emptied, sum));
+        }
+
+        subtractScalar(values, i, size, sums, counts);
+    }
+
+    __attribute__((target("avx2"))) void meanAvx2(const double *sums, const int *counts, int size, double *averages)
+    {
+        const __m256d nan = _mm256_set1_pd(qQNaN());
+
+        int i = 0;
+        for (; i + 4 <= size; i += 4)
+        {
+            __m256d count = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*> (counts + i)));
+            __m256d average = _mm256_div_pd(_mm256_loadu_pd(sums + i), count);
+            __m256d empty = _mm256_cmp_pd(count, _mm256_setzero_pd(), _CMP_LE_OQ);
+            _mm256_storeu_pd(averages + i, _mm256_blendv_pd(average, nan, empty));
+        }
+
+        meanScalar(sums, counts, i, size, averages);
+    }
+
+    // Two accumulators so consecutive adds do not wait on each other
+    __attribute__((target("avx2"))) double absoluteDifferenceAvx2(const double *values, const double *reference, int size, int *points)
+    {
+        const __m256d signBits = _mm256_set1_pd(-0.0);
+        const __m256d ones = _mm256_set1_pd(1.0);
+        __m256d total[2] = { _mm256_setzero_pd(), _mm256_setzero_pd() };
+        __m256d counted[2] = { _mm256_setzero_pd(), _mm256_setzero_pd() };
+
+        int i = 0;
+        for (; i + 8 <= size; i += 8)
+        {
+            for (int half = 0; half < 2; ++half)
+            {
+                __m256d difference = _mm256_sub_pd(_mm256_loadu_pd(values + i + 4 * half), _mm256_loadu_pd(reference + i + 4 * half));
+                __m256d valid = _mm256_cmp_pd(difference, difference, _CMP_ORD_Q);
+                total[half] = _mm256_add_pd(total[half], _mm256_and_pd(valid, _mm256_andnot_pd(signBits, difference)));
+                counted[half] = _mm256_add_pd(counted[half], _mm256_and_pd(valid, ones));
+            }
+        }
+
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_add_pd(counted[0], counted[1]));
+        *points += int(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+        _mm256_storeu_pd(lanes, _mm256_add_pd(total[0], total[1]));
+
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + absoluteDifferenceScalar(values, reference, i, size, points);
+    }
+#endif
+}
+
+StatKernels::StatKernels(Path path):
+    kernelPath(isSupported(path) ? path : Scalar)
+{
+}
+
+// Widest path this CPU can run
+StatKernels::Path StatKernels::bestPath()
+{
+    static const Path path = isSupported(Avx2) ? Avx2 : isSupported(Sse2) ? Sse2 : Scalar;
+    return path;
+}
+
+bool StatKernels::isSupported(Path path)
+{
+    switch (path)
+    {
+        case Scalar:
+            return true;
+#ifdef STATKERNELS_X86
+        case Sse2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case Avx2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+const char *StatKernels::pathName(Path path)
+{
+    switch (path)
+    {
+        case Sse2:
+            return "SSE2";
+        case Avx2:
+            return "AVX2";
+        default:
+            return "Scalar";
+    }
+}
+
+void StatKernels::accumulate(const double *values, int size, double *sums, int *counts) const
+{
+    switch (kernelPath)
+    {
+#ifdef STATKERNELS_X86
+        case Sse2:
+            return accumulateSse2(values, size, sums, counts);
+        case Avx2:
+            return accumulateAvx2(values, size, sums, counts);
+#endif
+        default:
+            return accumulateScalar(values, 0, size, sums, counts);
+    }
+}
+
+void StatKernels::subtract(const double *values, int size, double *sums, int *counts) const
+{
+    switch (kernelPath)
+    {
+#ifdef STATKERNELS_X86
+        case Sse2:
+            return subtractSse2(values, size, sums, counts);
+        case Avx2:
+            return subtractAvx2(values, size, sums, counts);
+#endif
+        default:
+            return subtractScalar(values, 0, size, sums, counts);
+    }
+}
+
+void StatKernels::mean(const double *sums, const int *counts, int size, double *averages) const
+{
+    switch (kernelPath)
+    {
+#ifdef STATKERNELS_X86
+        case Sse2:
+            return meanSse2(sums, counts, size, averages);
+        case Avx2:
+            return meanAvx2(sums, counts, size, averages);
+#endif
+        default:
+            return meanScalar(sums, counts, 0, size, averages);
+    }
+}
+
+double StatKernels::absoluteDifference(const double *values, const double *reference, int size, int *points) const
+{
+    *points = 0;
+    switch (kernelPath)
+    {
+#ifdef STATKERNELS_X86
+        case Sse2:
+            return absoluteDifferenceSse2(values, reference, size, points);
+        case Avx2:
+            return absoluteDifferenceAvx2(values, reference, size, points);
+#endif
+        default:
+            return absoluteDifferenceScalar(values, reference, 0, size, points);
+    }
+}
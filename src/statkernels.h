@@ -0,0 +1,42 @@
+#ifndef STATKERNELS_H
+#define STATKERNELS_H
+
+#include <QtGlobal>
+
+// Per-frequency loops of the averages and distance ratios over contiguous rows of doubles, using
+// the widest vector instructions the CPU supports. NaN points are never counted.
+class StatKernels
+{
+public:
+    enum Path
+    {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    explicit StatKernels(Path path = bestPath());
+
+    static Path bestPath();
+    static bool isSupported(Path path);
+    static const char *pathName(Path path);
+
+    Path path() const { return kernelPath; }
+
+    // sums[i] += values[i] and ++counts[i] where values[i] is not NaN
+    void accumulate(const double *values, int size, double *sums, int *counts) const;
+
+    // Undoes accumulate, a sum whose count drops to zero is reset to zero
+    void subtract(const double *values, int size, double *sums, int *counts) const;
+
+    // averages[i] = sums[i] / counts[i], NaN where nothing was counted
+    void mean(const double *sums, const int *counts, int size, double *averages) const;
+
+    // Sum of |values[i] - reference[i]| over the points where neither is NaN, their number in points
+    double absoluteDifference(const double *values, const double *reference, int size, int *points) const;
+
+private:
+    Path kernelPath;
+};
+
+#endif // STATKERNELS_H
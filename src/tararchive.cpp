@@ -0,0 +1,372 @@
+/**
+ *@file tararchive.cpp
+ *@brief Implementation of the tar bundle reader used to import whole production lots
+ *
+ *This file contains the implementation of a reader for the .tar bundles that hold the per-core
+ *sweep files of a production lot. A plain archive is memory-mapped and only its 512-byte member
+ *headers are read here; the members are then parsed in place, in parallel, without extracting
+ *anything to disk. A .tar.gz or .tgz bundle is streamed through the gzip device: opening it only
+ *walks the headers, and the members are inflated a second time while the workers parse them, so
+ *neither the archive nor its members ever have to fit in memory as a whole. ustar prefixes, GNU
+ *long names and pax path records are supported for the member paths.
+ *
+ *@note readMember may be called by several load workers at once, memberData only for a plain .tar.
+ *
+ *@date[10/16/26]
+ */
+#include "tararchive.h"
+#include "gzipdevice.h"
+#include <QMutexLocker>
+#include <cstring>
+
+namespace
+{
+    const int blockSize = 512;
+    const qint64 skipChunkBytes = 256 * 1024;
+
+    // Octal field, or base-256 when the top bit of the first byte is set (GNU large files)
+    qint64 numberField(const char *field, int length)
+    {
+        const uchar *bytes = reinterpret_cast<const uchar*> (field);
+        qint64 value = 0;
+
+        if (bytes[0] & 0x80)
+        {
+            value = bytes[0] & 0x7f;
+            for (int i = 1; i < length; ++i)
+            {
+                value = (value << 8) | bytes[i];
+            }
+
+            return value;
+        }
+
+        int i = 0;
+        while (i < length && (field[i] == ' ' || field[i] == '\0'))
+        {
+            ++i;
+        }
+
+        for (; i < length && field[i] >= '0' && field[i] <= '7'; ++i)
+        {
+            value = value * 8 + (field[i] - '0');
+        }
+
+        return value;
+    }
+
+    // NUL-terminated (or full-width) text field
+    QString textField(const char *field, int length)
+    {
+        return QString::fromUtf8(field, qstrnlen(field, length));
+    }
+
+    // Checksum is the byte sum of the header with the checksum field read as spaces
+    bool validChecksum(const char *header)
+    {
+        const uchar *bytes = reinterpret_cast<const uchar*> (header);
+        qint64 sum = 0;
+        for (int i = 0; i < blockSize; ++i)
+        {
+            sum += (i >= 148 && i < 156) ? ' ' : bytes[i];
+        }
+
+        return sum == numberField(header + 148, 8);
+    }
+
+    // Path record of a pax extended header, "<length> path=<value>\n"
+    QString paxPath(const char *data, qint64 size)
+    {
+        qint64 offset = 0;
+        while (offset < size)
+        {
+            qint64 length = 0;
+            qint64 i = offset;
+            for (; i < size && data[i] >= '0' && data[i] <= '9'; ++i)
+            {
+                length = length * 10 + (data[i] - '0');
+            }
+
+            if (length <= 0 || offset + length > size)
+            {
+                break;
+            }
+
+            QByteArray record(data + i + 1, length - (i + 1 - offset) - 1);
+            if (record.startsWith("path="))
+            {
+                return QString::fromUtf8(record.mid(5));
+            }
+
+            offset += length;
+        }
+
+        return QString();
+    }
+
+    inline qint64 paddedSize(qint64 size)
+    {
+        return (size + blockSize - 1) / blockSize * blockSize;
+    }
+}
+
+TarArchive::TarArchive(const QString &filePath, const QString &memberSuffix):
+    archivePath(filePath),
+    suffix(memberSuffix),
+    file(filePath)
+{
+}
+
+TarArchive::~TarArchive()
+{
+    if (mapped)
+    {
+        file.unmap(mapped);
+    }
+}
+
+bool TarArchive::isArchive(const QString &filePath)
+{
+    return filePath.endsWith(".tar", Qt::CaseInsensitive) ||
+           filePath.endsWith(".tar.gz", Qt::CaseInsensitive) ||
+           filePath.endsWith(".tgz", Qt::CaseInsensitive);
+}
+
+// Map a plain archive or stream a compressed one and list its regular members
+bool TarArchive::open(const QAtomicInt *cancelled)
+{
+    if (archivePath.endsWith(".tar", Qt::CaseInsensitive))
+    {
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            error = file.errorString();
+            return false;
+        }
+
+        archiveSize = file.size();
+        if (archiveSize > 0)
+        {
+            mapped = file.map(0, archiveSize);
+            if (mapped == nullptr)
+            {
+                // Some devices cannot be mapped, fall back to a single read
+                unmappable = file.readAll();
+                archiveSize = unmappable.size();
+            }
+        }
+
+        // The file stays open, closing it would unmap it
+        archiveData = mapped ? reinterpret_cast<const char*> (mapped) : unmappable.constData();
+        return readMembers([this](qint64 offset, qint64 size) -> const char *
+                           {
+                               if (offset > archiveSize)
+                               {
+                                   error = "Truncated tar archive";
+                                   return nullptr;
+                               }
+
+                               return offset + size <= archiveSize ? archiveData + offset : nullptr;
+                           }, cancelled);
+    }
+
+    // Headers and long names only, the member contents are skipped while inflating
+    stream.reset(new GzipDevice(archivePath));
+    if (!stream->open(QIODevice::ReadOnly))
+    {
+        error = stream->errorString();
+        return false;
+    }
+
+    streamOffset = 0;
+    archiveSize = -1;	// Not known before the end of the stream
+    QByteArray block;
+    bool ok = readMembers([this, &block](qint64 offset, qint64 size) -> const char *
+                          {
+                              if (!streamTo(offset))
+                              {
+                                  error = "Truncated tar archive";
+                                  return nullptr;
+                              }
+
+                              block.resize(size);
+                              return streamRead(block.data(), size) ? block.constData() : nullptr;
+                          }, cancelled);
+
+    // readMember starts a new pass
+    stream.reset();
+    return ok;
+}
+
+// Walk the member headers, fetch gives size bytes at an archive offset or nullptr past the end.
+// The offsets only grow, so a compressed archive is read once from start to end.
+bool TarArchive::readMembers(const Fetch &fetch, const QAtomicInt *cancelled)
+{
+    memberList.clear();
+
+    QString longPath;	// From a GNU 'L' or pax 'x' entry, applies to the next member
+    qint64 offset = 0;
+    for (;;)
+    {
+        if (cancelled && cancelled->loadRelaxed())
+        {
+            error = "Cancelled";
+            return false;
+        }
+
+        const char *header = fetch(offset, blockSize);
+
+        // End of the data or two zero blocks end the archive, one is enough to stop
+        if (header == nullptr || header[0] == '\0')
+        {
+            break;
+        }
+
+        if (!validChecksum(header))
+        {
+            error = QString("Corrupt tar header at offset %1").arg(offset);
+            return false;
+        }
+
+        qint64 size = numberField(header + 124, 12);
+        qint64 dataOffset = offset + blockSize;
+        if (size < 0 || (archiveSize >= 0 && dataOffset + size > archiveSize))
+        {
+            error = "Truncated tar archive";
+            return false;
+        }
+
+        char type = header[156];
+        if (type == 'L' || type == 'x')
+        {
+            const char *data = fetch(dataOffset, size);
+            if (data == nullptr)
+            {
+                error = "Truncated tar archive";
+                return false;
+            }
+
+            longPath = type == 'L' ? QString::fromUtf8(data, qstrnlen(data, size)) : paxPath(data, size);
+        }
+        else if (type == '0' || type == '\0' || type == '7')
+        {
+            TarMember member;
+            member.offset = dataOffset;
+            member.size = size;
+
+            if (!longPath.isEmpty())
+            {
+                member.path = longPath;
+            }
+            else
+            {
+                member.path = textField(header, 100);
+
+                // ustar splits long paths into prefix and name
+                if (std::memcmp(header + 257, "ustar", 5) == 0 && header[345] != '\0')
+                {
+                    member.path = textField(header + 345, 155) + '/' + member.path;
+                }
+            }
+
+            if (member.path.endsWith(suffix, Qt::CaseInsensitive))
+            {
+                memberList.append(member);
+            }
+
+            longPath.clear();
+        }
+        else if (type != 'g')
+        {
+            // Directories, links and devices have no sweep data
+            longPath.clear();
+        }
+
+        offset = dataOffset + paddedSize(size);
+    }
+
+    return error.isEmpty();
+}
+
+// Skip the stream forward to offset, false when it ends before
+bool TarArchive::streamTo(qint64 offset)
+{
+    QByteArray skipped(int(qMin(skipChunkBytes, qMax<qint64>(offset - streamOffset, 1))), Qt::Uninitialized);
+    while (streamOffset < offset)
+    {
+        qint64 read = stream->read(skipped.data(), qMin<qint64>(skipped.size(), offset - streamOffset));
+        if (read <= 0)
+        {
+            return false;
+        }
+
+        streamOffset += read;
+    }
+
+    return true;
+}
+
+// Exactly size bytes, the device hands out what it has inflated so far
+bool TarArchive::streamRead(char *data, qint64 size)
+{
+    qint64 copied = 0;
+    while (copied < size)
+    {
+        qint64 read = stream->read(data + copied, size - copied);
+        if (read <= 0)
+        {
+            return false;
+        }
+
+        copied += read;
+    }
+
+    streamOffset += size;
+    return true;
+}
+
+bool TarArchive::readMember(const TarMember &member, QByteArray &data)
+{
+    QMutexLocker locker(&streamMutex);
+
+    // Read ahead by the worker of an earlier member
+    if (pending.contains(member.offset))
+    {
+        data = pending.take(member.offset);
+        return true;
+    }
+
+    if (!stream)
+    {
+        stream.reset(new GzipDevice(archivePath));
+        if (!stream->open(QIODevice::ReadOnly))
+        {
+            error = stream->errorString();
+            return false;
+        }
+
+        streamOffset = 0;
+        nextMember = 0;
+    }
+
+    while (nextMember < memberList.size() && memberList[nextMember].offset <= member.offset)
+    {
+        const TarMember &next = memberList[nextMember++];
+
+        QByteArray contents(int(next.size), Qt::Uninitialized);
+        if (!streamTo(next.offset) || !streamRead(contents.data(), next.size))
+        {
+            error = "Truncated tar archive";
+            return false;
+        }
+
+        if (next.offset == member.offset)
+        {
+            data = contents;
+            return true;
+        }
+
+        pending.insert(next.offset, contents);
+    }
+
+    return false;
+}
@@ -0,0 +1,78 @@
+#ifndef TARARCHIVE_H
+#define TARARCHIVE_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QScopedPointer>
+#include <functional>
+
+class GzipDevice;
+
+// A regular file inside a tar archive
+struct TarMember
+{
+    QString path;	// Member path inside the archive
+    qint64 offset = 0;	// Start of the contents in the (inflated) archive
+    qint64 size = 0;
+};
+
+// Read-only view of a .tar, .tar.gz or .tgz bundle. Plain archives are memory-mapped, so the
+// members are parsed straight from the mapping; compressed ones are streamed, nothing but the
+// member headers is kept when they are opened and the members are inflated again as they are read.
+class TarArchive
+{
+public:
+    // Only members whose path ends with memberSuffix are listed, every member when it is empty
+    explicit TarArchive(const QString &filePath, const QString &memberSuffix = QString());
+    ~TarArchive();
+
+    // Walk the member headers, stops with false once cancelled is set
+    bool open(const QAtomicInt *cancelled = nullptr);
+    QString errorString() const { return error; }
+    QString filePath() const { return archivePath; }
+
+    const QVector<TarMember> &members() const { return memberList; }
+
+    // Contents of a mapped member, nullptr for a compressed archive
+    bool isMapped() const { return archiveData != nullptr; }
+    const char *memberData(const TarMember &member) const { return archiveData + member.offset; }
+
+    // Contents of a member of a compressed archive, safe to call from several threads. Members are
+    // inflated in archive order; the ones passed on the way are kept until they are asked for.
+    bool readMember(const TarMember &member, QByteArray &data);
+
+    static bool isArchive(const QString &filePath);
+
+private:
+    typedef std::function<const char *(qint64 offset, qint64 size)> Fetch;
+
+    bool readMembers(const Fetch &fetch, const QAtomicInt *cancelled);
+    bool streamTo(qint64 offset);
+    bool streamRead(char *data, qint64 size);
+
+    QString archivePath;
+    QString suffix;
+    QFile file;
+    uchar *mapped = nullptr;
+    QByteArray unmappable;	// Whole archive when the file cannot be mapped
+    const char *archiveData = nullptr;
+    qint64 archiveSize = 0;
+    QVector<TarMember> memberList;
+    QString error;
+
+    // Second pass through a compressed archive
+    QMutex streamMutex;
+    QScopedPointer<GzipDevice> stream;
+    qint64 streamOffset = 0;
+    int nextMember = 0;
+    QHash<qint64, QByteArray> pending;	// Member offset -> contents read ahead for another worker
+
+    Q_DISABLE_COPY(TarArchive)
+};
+
+#endif // TARARCHIVE_H
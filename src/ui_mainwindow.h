@@ -79,6 +79,7 @@ public:
     QGridLayout *gridLayout_2;
     QPushButton *btn_load_plot;
     QPushButton *btn_clear_plot;
+    QPushButton *btn_add_plot;
     QPushButton *btn_start_plot;
     QPushButton *btn_save_plot;
     QStatusBar *statusbar;
@@ -594,6 +595,14 @@ public:
 
         gridLayout_2->addWidget(btn_save_plot, 1, 1, 1, 1);
 
+        btn_add_plot = new QPushButton(centralwidget);
+        btn_add_plot->setObjectName("btn_add_plot");
+        btn_add_plot->setFont(font5);
+        btn_add_plot->setFocusPolicy(Qt::TabFocus);
+        btn_add_plot->setStyleSheet(QString::fromUtf8(""));
+
+        gridLayout_2->addWidget(btn_add_plot, 2, 0, 1, 2);
+
 
         gridLayout_5->addLayout(gridLayout_2, 0, 5, 1, 2);
 
@@ -634,7 +643,8 @@ public:
         QWidget::setTabOrder(btn_export_avg, doubleSpinBox);
         QWidget::setTabOrder(doubleSpinBox, btn_HighlightGraphs);
         QWidget::setTabOrder(btn_HighlightGraphs, btn_load_plot);
-        QWidget::setTabOrder(btn_load_plot, btn_clear_plot);
+        QWidget::setTabOrder(btn_load_plot, btn_add_plot);
+        QWidget::setTabOrder(btn_add_plot, btn_clear_plot);
         QWidget::setTabOrder(btn_clear_plot, btn_start_plot);
         QWidget::setTabOrder(btn_start_plot, btn_save_plot);
         QWidget::setTabOrder(btn_save_plot, cbox_Lines);
@@ -705,6 +715,7 @@ public:
         btn_clear_plot->setText(QCoreApplication::translate("MainWindow", "Clear Plot", nullptr));
         btn_start_plot->setText(QCoreApplication::translate("MainWindow", "Default", nullptr));
         btn_save_plot->setText(QCoreApplication::translate("MainWindow", "Export Graph as PNG", nullptr));
+        btn_add_plot->setText(QCoreApplication::translate("MainWindow", "Add CSV Files", nullptr));
         toolBar->setWindowTitle(QCoreApplication::translate("MainWindow", "toolBar", nullptr));
         menuSettings->setTitle(QCoreApplication::translate("MainWindow", "Settings", nullptr));
     } // retranslateUi
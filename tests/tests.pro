@@ -0,0 +1,7 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    tst_coredataset \
+    tst_csvscanner \
+    tst_resampler \
+    tst_statkernels
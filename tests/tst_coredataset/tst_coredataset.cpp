@@ -0,0 +1,199 @@
+/**
+ *@file tst_coredataset.cpp
+ *@brief Tests of the frequency grid a load batch gives the dataset
+ *
+ *The files of a batch finish parsing in any order. These tests load the same files into a
+ *dataset in slot order and in reverse completion order, through the BatchOrder the loader
+ *uses, and check that both give the same grids and the same rows. A file streamed in small
+ *chunks into its file-backed columns has to give the rows of the same file parsed at once.
+ *
+ *@date[10/16/26]
+ */
+#include <QtTest>
+#include <QTemporaryFile>
+#include "coredataset.h"
+#include "csvparser.h"
+
+class CoreDatasetTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void gridFromLowestSlot_data();
+    void gridFromLowestSlot();
+    void heldFilesAfterRelease();
+    void streamedFileMatchesParsed();
+
+private:
+    static QVector<CsvParseResult> parseBatch();
+    static void load(CoreDataset &dataset, const QVector<CsvParseResult> &batch, const QVector<int> &completion,
+                     const GridOptions &options);
+};
+
+// Three sweeps on different frequencies and with different point counts
+QVector<CsvParseResult> CoreDatasetTest::parseBatch()
+{
+    const char *files[] = {
+        "FREQUENCY,Ls,Rs\n100,1,10\n200,2,20\n300,3,30\n400,4,40\n500,5,50\n",
+        "FREQUENCY,Ls,Rs\n150,1.5,15\n250,2.5,25\n350,3.5,35\n",
+        "FREQUENCY,Ls,Rs\n100,6,60\n175,7,70\n250,8,80\n325,9,90\n400,10,100\n475,11,110\n550,12,120\n"
+    };
+
+    CsvParser parser(0, 1000, 0, 1000);
+    QVector<CsvParseResult> batch;
+    for (const char *file: files)
+    {
+        batch.append(parser.parseMemory("core.csv", file, qstrlen(file)));
+    }
+
+    return batch;
+}
+
+// Feed the batch to the dataset in completion order the way MainWindow does
+void CoreDatasetTest::load(CoreDataset &dataset, const QVector<CsvParseResult> &batch, const QVector<int> &completion,
+                           const GridOptions &options)
+{
+    dataset.clear();
+    dataset.channel(true).setGridOptions(options);
+    dataset.channel(false).setGridOptions(options);
+    for (int i = 0; i < batch.size(); ++i)
+    {
+        dataset.appendCore(QString("core_%1").arg(i));
+    }
+
+    BatchOrder order;
+    order.reset(batch.size());
+    for (int index: completion)
+    {
+        for (int ready: order.arrive(index))
+        {
+            dataset.setCore(ready, batch[ready]);
+        }
+
+        if (!order.isReleased() && dataset.channel(true).frequencyCount() > 0 && dataset.channel(false).frequencyCount() > 0)
+        {
+            for (int ready: order.release())
+            {
+                dataset.setCore(ready, batch[ready]);
+            }
+        }
+    }
+
+    for (int ready: order.release())
+    {
+        dataset.setCore(ready, batch[ready]);
+    }
+}
+
+void CoreDatasetTest::gridFromLowestSlot_data()
+{
+    QTest::addColumn<int> ("spacing");
+
+    QTest::newRow("first core") << int(GridOptions::FirstCore);
+    QTest::newRow("linear, points of the first core") << int(GridOptions::LinearSpacing);
+    QTest::newRow("log, points of the first core") << int(GridOptions::LogSpacing);
+}
+
+void CoreDatasetTest::gridFromLowestSlot()
+{
+    QFETCH(int, spacing);
+
+    GridOptions options;
+    options.spacing = GridOptions::Spacing(spacing);
+
+    QVector<CsvParseResult> batch = parseBatch();
+    CoreDataset inOrder;
+    CoreDataset reversed;
+    load(inOrder, batch, {0, 1, 2}, options);
+    load(reversed, batch, {2, 1, 0}, options);
+
+    for (bool useLsData: {true, false})
+    {
+        const ChannelMatrix &expected = inOrder.channel(useLsData);
+        const ChannelMatrix &actual = reversed.channel(useLsData);
+
+        // The grid and its point count follow slot 0, not the file that finished first
+        QCOMPARE(actual.frequencyCount(), 5);
+        QCOMPARE(actual.frequencies(), expected.frequencies());
+        QCOMPARE(actual.frequencies().first(), 100.0);
+        QCOMPARE(actual.frequencies().last(), 500.0);
+
+        for (int core = 0; core < batch.size(); ++core)
+        {
+            QVERIFY(actual.hasCore(core));
+            ColumnSpan expectedRow = expected.core(core);
+            ColumnSpan actualRow = actual.core(core);
+            QCOMPARE(actualRow.size(), expectedRow.size());
+            for (int i = 0; i < expectedRow.size(); ++i)
+            {
+                QVERIFY(qIsNaN(actualRow[i]) ? qIsNaN(expectedRow[i]) : actualRow[i] == expectedRow[i]);
+            }
+        }
+    }
+}
+
+void CoreDatasetTest::heldFilesAfterRelease()
+{
+    BatchOrder order;
+    order.reset(4);
+
+    // Nothing goes in before slot 0, then the run that is ready
+    QCOMPARE(order.arrive(3), QVector<int> ());
+    QCOMPARE(order.arrive(1), QVector<int> ());
+    QCOMPARE(order.arrive(0), QVector<int> ({0, 1}));
+
+    // Once released, held files come in slot order and later ones straight through
+    QCOMPARE(order.release(), QVector<int> ({3}));
+    QVERIFY(order.isReleased());
+    QCOMPARE(order.arrive(2), QVector<int> ({2}));
+    QCOMPARE(order.release(), QVector<int> ());
+}
+
+void CoreDatasetTest::streamedFileMatchesParsed()
+{
+    // Out of order rows, so the streamed columns are sorted in place as well
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write("FREQUENCY,Ls,Rs\n");
+    for (int i = 0; i < 500; ++i)
+    {
+        int row = (i * 173) % 500;
+        file.write(QByteArray::number(100 + row * 2) + "," + QByteArray::number(row % 7) + "," + QByteArray::number(row % 11) + "\n");
+    }
+
+    file.close();
+
+    CsvParser parser(200, 800, 300, 1000);
+    CsvParseResult parsed = parser.parseFile(file.fileName());
+    int chunks = 0;
+    CsvParseResult streamed = parser.parseStream(file.fileName(), 256, [&chunks](const CoreColumns &)
+                                                 {
+                                                     ++chunks;
+                                                     return true;
+                                                 });
+
+    QVERIFY(chunks > 1);
+    QVERIFY(!streamed.streamedColumns.isNull());
+    QVERIFY(streamed.columns.frequencies.isEmpty());
+    QCOMPARE(streamed.rowCount(), parsed.rowCount());
+    QCOMPARE(streamed.contentHash, parsed.contentHash);
+
+    CoreDataset fromParsed;
+    CoreDataset fromStreamed;
+    fromParsed.appendCore("parsed");
+    fromStreamed.appendCore("streamed");
+    QVERIFY(fromParsed.setCore(0, parsed));
+    QVERIFY(fromStreamed.setCore(0, streamed));
+
+    for (bool useLsData: {true, false})
+    {
+        ColumnSpan expected = fromParsed.channel(useLsData).core(0);
+        ColumnSpan row = fromStreamed.channel(useLsData).core(0);
+        QVERIFY(!expected.isEmpty());
+        QCOMPARE(QVector<double> (row.begin(), row.end()), QVector<double> (expected.begin(), expected.end()));
+    }
+}
+
+QTEST_APPLESS_MAIN(CoreDatasetTest)
+
+#include "tst_coredataset.moc"
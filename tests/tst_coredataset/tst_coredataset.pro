@@ -0,0 +1,24 @@
+QT += testlib
+QT -= gui
+
+CONFIG += c++17 testcase
+CONFIG -= app_bundle
+
+# The dataset sources are built from src/, the parser only for its result types and parseMemory
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+qtConfig(system-zlib) {
+    LIBS += -lz
+} else {
+    QT += zlib-private
+}
+
+SOURCES += \
+    tst_coredataset.cpp \
+    $$SRC/coredataset.cpp \
+    $$SRC/csvparser.cpp \
+    $$SRC/csvscanner.cpp \
+    $$SRC/gzipdevice.cpp \
+    $$SRC/matrixstore.cpp \
+    $$SRC/resampler.cpp
@@ -0,0 +1,108 @@
+/**
+ *@file tst_statkernels.cpp
+ *@brief Tests that every SIMD path of the statistics kernels gives the scalar results
+ *
+ *The scalar loops are the reference. Each vector path the CPU supports runs on the same random
+ *rows, from empty up to a few vector widths with a ragged tail and with NaN points mixed in.
+ *The per-frequency kernels have to give the same sums, counts and averages bit for bit; the
+ *distance is a reduction summed in another order, so it only has to agree to rounding.
+ *
+ *@date[10/16/26]
+ */
+#include <QtTest>
+#include <QRandomGenerator>
+#include <cstring>
+#include "statkernels.h"
+
+class StatKernelsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchesScalar_data();
+    void matchesScalar();
+};
+
+namespace
+{
+    QVector<double> randomRow(QRandomGenerator &random, int size)
+    {
+        QVector<double> row(size);
+        for (double &value: row)
+        {
+            value = random.bounded(8) == 0 ? qQNaN() : (random.generateDouble() - 0.5) * 1e-3;
+        }
+
+        return row;
+    }
+
+    // Same bits, so NaN equals NaN
+    bool sameDoubles(const QVector<double> &a, const QVector<double> &b)
+    {
+        return a.size() == b.size() && std::memcmp(a.constData(), b.constData(), sizeof(double) * a.size()) == 0;
+    }
+}
+
+void StatKernelsTest::matchesScalar_data()
+{
+    QTest::addColumn<int> ("path");
+
+    QTest::newRow(StatKernels::pathName(StatKernels::Sse2)) << int(StatKernels::Sse2);
+    QTest::newRow(StatKernels::pathName(StatKernels::Avx2)) << int(StatKernels::Avx2);
+}
+
+void StatKernelsTest::matchesScalar()
+{
+    QFETCH(int, path);
+
+    if (!StatKernels::isSupported(StatKernels::Path(path)))
+    {
+        QSKIP("Path not supported by this CPU");
+    }
+
+    StatKernels reference(StatKernels::Scalar);
+    StatKernels kernels(StatKernels::Path(path));
+
+    QRandomGenerator random(20261016);
+    for (int round = 0; round < 2000; ++round)
+    {
+        int size = random.bounded(301);
+        QVector<double> first = randomRow(random, size);
+        QVector<double> second = randomRow(random, size);
+
+        // Two cores in, the first one out again
+        QVector<double> expectedSums(size, 0.0);
+        QVector<int> expectedCounts(size, 0);
+        reference.accumulate(first.constData(), size, expectedSums.data(), expectedCounts.data());
+        reference.accumulate(second.constData(), size, expectedSums.data(), expectedCounts.data());
+
+        QVector<double> sums(size, 0.0);
+        QVector<int> counts(size, 0);
+        kernels.accumulate(first.constData(), size, sums.data(), counts.data());
+        kernels.accumulate(second.constData(), size, sums.data(), counts.data());
+        QVERIFY(sameDoubles(sums, expectedSums));
+        QCOMPARE(counts, expectedCounts);
+
+        reference.subtract(first.constData(), size, expectedSums.data(), expectedCounts.data());
+        kernels.subtract(first.constData(), size, sums.data(), counts.data());
+        QVERIFY(sameDoubles(sums, expectedSums));
+        QCOMPARE(counts, expectedCounts);
+
+        QVector<double> expectedAverages(size);
+        QVector<double> averages(size);
+        reference.mean(expectedSums.constData(), expectedCounts.constData(), size, expectedAverages.data());
+        kernels.mean(sums.constData(), counts.constData(), size, averages.data());
+        QVERIFY(sameDoubles(averages, expectedAverages));
+
+        int expectedPoints = 0;
+        int points = 0;
+        double expectedDistance = reference.absoluteDifference(first.constData(), second.constData(), size, &expectedPoints);
+        double distance = kernels.absoluteDifference(first.constData(), second.constData(), size, &points);
+        QCOMPARE(points, expectedPoints);
+        QVERIFY(qAbs(distance - expectedDistance) <= 1e-12 * qMax(1.0, qAbs(expectedDistance)));
+    }
+}
+
+QTEST_APPLESS_MAIN(StatKernelsTest)
+
+#include "tst_statkernels.moc"
@@ -0,0 +1,12 @@
+QT += testlib
+QT -= gui
+
+CONFIG += c++17 testcase
+CONFIG -= app_bundle
+
+SRC = $$PWD/../../src
+INCLUDEPATH += $$SRC
+
+SOURCES += \
+    tst_statkernels.cpp \
+    $$SRC/statkernels.cpp